@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "chess/core.hpp"
+
+using namespace chess;
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+void print_usage(const char* program) {
+    std::fprintf(stderr,
+        "Usage: %s [-d] [-n] [-t <threads>] [-H <MiB>] <depth> [<fen>]\n"
+        "  -d  divide - print number of leaf nodes after each root move\n"
+        "  -n  no bulk counting - make the moves of the last ply instead of counting them\n"
+        "  -t  number of threads, defaults to the number of hardware threads\n"
+        "  -H  hash table size in MiB, 0 disables it, defaults to 64\n"
+        "Position defaults to the starting position.\n", program);
+}
+
+piece_t parse_piece(const char symbol) {
+    switch (symbol) {
+        case 'p': return PIECE_PAWN;
+        case 'n': return PIECE_KNIGHT;
+        case 'b': return PIECE_BISHOP;
+        case 'r': return PIECE_ROOK;
+        case 'q': return PIECE_QUEEN;
+        case 'k': return PIECE_KING;
+        default: return PIECE_EMPTY;
+    }
+}
+
+/** Reads piece placement, side to move, castling rights and en passant field of a FEN record.
+ *  En passant field is stored as the last move - double step of the opponent's pawn. */
+bool parse_fen(const std::string& fen, board_state_t& board, player_t& player) {
+    std::istringstream stream(fen);
+    std::string placement, side, castling = "-", en_passant = "-";
+    if (not (stream >> placement >> side))
+        return false;
+    stream >> castling >> en_passant;
+
+    board = EMPTY_BOARD;
+    int file = 0;
+    int rank = 7;
+    for (const char symbol : placement) {
+        if ('/' == symbol) {
+            file = 0;
+            --rank;
+        } else if ('1' <= symbol and symbol <= '8') {
+            file += symbol - '0';
+        } else {
+            const piece_t piece = parse_piece(std::tolower(symbol));
+            if (PIECE_EMPTY == piece or file > 7 or rank < 0)
+                return false;
+            board[make_field(file++, rank)] =
+                field_set_piece(std::isupper(symbol) ? FW : FB, piece);
+        }
+    }
+
+    if ("w" != side and "b" != side)
+        return false;
+    player = "w" == side ? PLAYER_WHITE : PLAYER_BLACK;
+
+    castling_rights_t rights = {};
+    if (std::string::npos == castling.find('K'))
+        rights = castling_rights_remove_white_short(rights);
+    if (std::string::npos == castling.find('Q'))
+        rights = castling_rights_remove_white_long(rights);
+    if (std::string::npos == castling.find('k'))
+        rights = castling_rights_remove_black_short(rights);
+    if (std::string::npos == castling.find('q'))
+        rights = castling_rights_remove_black_long(rights);
+    board_state_meta_set_castling_rights(board, rights);
+
+    if ("-" != en_passant) {
+        if (2 != en_passant.size())
+            return false;
+        const int en_passant_file = en_passant[0] - 'a';
+        const int en_passant_rank = en_passant[1] - '1';
+        const int direction = PLAYER_WHITE == player ? 1 : -1;
+        last_move_t last_move = {};
+        last_move = last_move_set_player(last_move, opponent(player));
+        last_move = last_move_set_piece(last_move, PIECE_PAWN);
+        last_move = last_move_set_from(
+            last_move, make_field(en_passant_file, en_passant_rank + direction));
+        last_move = last_move_set_to(
+            last_move, make_field(en_passant_file, en_passant_rank - direction));
+        board_state_meta_set_last_move(board, last_move);
+    }
+
+    update_fields_under_attack(board);
+    return true;
+}
+
+std::string move_name(const move_t move) {
+    std::string name;
+    for (const field_t field : { move_get_from(move), move_get_to(move) }) {
+        name += static_cast<char>('a' + static_cast<int>(field_file(field)));
+        name += static_cast<char>('1' + static_cast<int>(field_rank(field)));
+    }
+    if (MOVE_FLAG_PROMOTION == move_get_flags(move))
+        name += " pnbrqk"[move_get_promotion(move)];
+    return name;
+}
+
+/** Entry of the hash table of subtree node counts
+ *  Threads access entries without locks. `key` is stored xor-ed with `data`, so an entry torn by a
+ *  concurrent write does not verify and is treated as a miss.
+ */
+struct perft_hash_entry_t {
+    std::atomic<uint64_t> key;
+    /** Node count in bits 8-63, depth in bits 0-7 */
+    std::atomic<uint64_t> data;
+};
+
+struct perft_hash_t {
+    std::unique_ptr<perft_hash_entry_t[]> entries;
+    std::size_t mask = 0;
+};
+
+perft_hash_t perft_hash;
+
+void perft_hash_init(const std::size_t size_mib) {
+    std::size_t entries_cnt = 1;
+    while (entries_cnt * 2 * sizeof(perft_hash_entry_t) <= (size_mib << 20))
+        entries_cnt *= 2;
+    if (0 == size_mib)
+        return;
+    perft_hash.entries.reset(new perft_hash_entry_t[entries_cnt]);
+    for (std::size_t idx = 0; idx < entries_cnt; ++idx) {
+        perft_hash.entries[idx].key.store(0, std::memory_order_relaxed);
+        perft_hash.entries[idx].data.store(0, std::memory_order_relaxed);
+    }
+    perft_hash.mask = entries_cnt - 1;
+}
+
+bool perft_hash_probe(const uint64_t hash, const int depth, std::size_t& nodes) {
+    const auto& entry = perft_hash.entries[hash & perft_hash.mask];
+    const uint64_t data = entry.data.load(std::memory_order_relaxed);
+    if ((entry.key.load(std::memory_order_relaxed) ^ data) != hash or
+        static_cast<uint64_t>(depth) != (data & 0xff))
+        return false;
+    nodes = data >> 8;
+    return true;
+}
+
+void perft_hash_store(const uint64_t hash, const int depth, const std::size_t nodes) {
+    auto& entry = perft_hash.entries[hash & perft_hash.mask];
+    const uint64_t data = (static_cast<uint64_t>(nodes) << 8) | static_cast<uint64_t>(depth);
+    entry.key.store(hash ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+/** Counts leaf nodes `depth` plies below the position
+ *  With `bulk` counting, moves of the last ply are counted without being made. Subtrees of
+ *  transposed positions are counted once when the hash table is enabled. */
+std::size_t perft(const board_state_t& board, const player_t player, const int depth,
+    const bool bulk) {
+    if (0 == depth)
+        return 1;
+    if (bulk and 1 == depth) {
+        move_t moves[256];
+        return fill_move_list(moves, board, player) - moves;
+    }
+
+    const bool use_hash = perft_hash.entries and depth > 1;
+    const uint64_t hash = use_hash ? position_key(board) : 0u;
+    std::size_t nodes = 0;
+    if (use_hash and perft_hash_probe(hash, depth, nodes))
+        return nodes;
+
+    board_state_t moves[256];
+    board_state_t* moves_end = fill_candidate_moves(moves, board, player);
+    for (auto it = moves; it != moves_end; ++it)
+        nodes += perft(*it, opponent(player), depth - 1, bulk);
+
+    if (use_hash)
+        perft_hash_store(hash, depth, nodes);
+    return nodes;
+}
+
+/** Subtree counted by one thread, position after the first plies of the tree */
+struct perft_task_t {
+    board_state_t board;
+    player_t player;
+    /** Index of the root move the subtree belongs to */
+    std::size_t root_move_idx;
+};
+
+void fill_perft_tasks(std::vector<perft_task_t>& tasks, const board_state_t& board,
+    const player_t player, const int plies, const std::size_t root_move_idx) {
+    if (0 == plies) {
+        tasks.push_back({ board, player, root_move_idx });
+        return;
+    }
+    board_state_t moves[256];
+    board_state_t* moves_end = fill_candidate_moves(moves, board, player);
+    for (auto it = moves; it != moves_end; ++it)
+        fill_perft_tasks(tasks, *it, opponent(player), plies - 1, root_move_idx);
+}
+
+/** Counts leaf nodes after each root move with a pool of threads
+ *  The first two plies are split into tasks - several hundred in a typical position - which idle
+ *  threads take from a shared counter, so a thread finishing a small subtree immediately picks up
+ *  more work instead of waiting for the others.
+ */
+std::vector<std::size_t> parallel_perft(const board_state_t& board, const player_t player,
+    const move_t* root_moves, const move_t* root_moves_end, const int depth, const bool bulk,
+    const unsigned threads_cnt) {
+    const int split_plies = depth > 2 ? 2 : 1;
+    std::vector<perft_task_t> tasks;
+    for (auto it = root_moves; it != root_moves_end; ++it) {
+        fill_perft_tasks(tasks, apply_move(board, *it), opponent(player), split_plies - 1,
+            it - root_moves);
+    }
+
+    std::vector<std::atomic<std::size_t>> root_nodes(root_moves_end - root_moves);
+    for (auto& nodes : root_nodes)
+        nodes.store(0, std::memory_order_relaxed);
+    std::atomic<std::size_t> next_task_idx(0);
+    auto worker = [&]() {
+        for (std::size_t task_idx = next_task_idx++; task_idx < tasks.size();
+             task_idx = next_task_idx++) {
+            const auto& task = tasks[task_idx];
+            root_nodes[task.root_move_idx] +=
+                perft(task.board, task.player, depth - split_plies, bulk);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned thread_idx = 1; thread_idx < threads_cnt; ++thread_idx)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    return std::vector<std::size_t>(root_nodes.begin(), root_nodes.end());
+}
+
+std::size_t run_perft(const board_state_t& board, const player_t player, const int depth,
+    const bool bulk, const bool divide_mode, const unsigned threads_cnt) {
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player);
+    const auto root_nodes =
+        parallel_perft(board, player, moves, moves_end, depth, bulk, threads_cnt);
+    std::size_t nodes = 0;
+    for (auto it = moves; it != moves_end; ++it) {
+        if (divide_mode)
+            std::printf("%s: %zu\n", move_name(*it).c_str(), root_nodes[it - moves]);
+        nodes += root_nodes[it - moves];
+    }
+    if (divide_mode)
+        std::printf("\n");
+    return nodes;
+}
+
+int main(int argc, char** argv) {
+    bool divide_mode = false;
+    bool bulk = true;
+    unsigned threads_cnt = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t hash_size_mib = 64;
+    int arg_idx = 1;
+    for (; arg_idx < argc and '-' == argv[arg_idx][0]; ++arg_idx) {
+        if (0 == std::strcmp("-d", argv[arg_idx])) {
+            divide_mode = true;
+        } else if (0 == std::strcmp("-n", argv[arg_idx])) {
+            bulk = false;
+        } else if (0 == std::strcmp("-t", argv[arg_idx]) and arg_idx + 1 < argc) {
+            threads_cnt = std::max(1, std::atoi(argv[++arg_idx]));
+        } else if (0 == std::strcmp("-H", argv[arg_idx]) and arg_idx + 1 < argc) {
+            hash_size_mib = std::strtoul(argv[++arg_idx], nullptr, 10);
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (arg_idx == argc) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const int depth = std::atoi(argv[arg_idx++]);
+
+    std::string fen;
+    for (; arg_idx < argc; ++arg_idx)
+        fen += std::string(argv[arg_idx]) + ' ';
+    if (fen.empty())
+        fen = START_FEN;
+
+    board_state_t board;
+    player_t player;
+    if (depth < 1 or not parse_fen(fen, board, player)) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    perft_hash_init(hash_size_mib);
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t nodes = run_perft(board, player, depth, bulk, divide_mode, threads_cnt);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::printf("Nodes: %zu\n", nodes);
+    std::printf("Time: %.3f s\n", elapsed.count());
+    std::printf("NPS: %.0f\n", elapsed.count() > 0 ? nodes / elapsed.count() : 0.0);
+    std::printf("Threads: %u\n", threads_cnt);
+    return EXIT_SUCCESS;
+}
@@ -4,6 +4,7 @@
 #include <thread>
 #include <unordered_map>
 #include "chess/gameplay.hpp"
+#include "chess/move_picker.hpp"
 #include "chess/gui_tty.hpp"
 
 using namespace chess;
@@ -50,10 +51,6 @@ int gen_random_num(int max_num, int min_num = 0) {
     return dis(gen);
 }
 
-std::size_t intpow(const std::size_t num, const std::size_t exp) {
-    return exp ? num * pow(num, exp - 1) : 1;
-}
-
 using score_t = int;
 static constexpr score_t MAX_SCORE = 100000;
 static constexpr score_t MIN_SCORE = -100000;
@@ -62,7 +59,7 @@ std::random_device score_rd;
 std::mt19937 score_gen(score_rd());
 std::uniform_int_distribution<> score_distr(-2, 2);
 
-score_t score_position(const board_state_t& board) {
+score_t score_position(const board_state_t& board, const piece_list_t& pieces) {
     constexpr score_t KNIGHT_SCORE = 3;
     constexpr score_t BISHOP_SCORE = 3;
     constexpr score_t ROOK_SCORE = 5;
@@ -79,27 +76,27 @@ score_t score_position(const board_state_t& board) {
     };
 
     float total_score = 0;
-    for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
-         field_idx < static_cast<uint8_t>(field_t::END);
-         ++field_idx) {
-        const auto field = board[field_idx];
-        score_t sign = (PLAYER_WHITE == field_get_player(field) ? 1 : -1 );
-        switch (field_get_piece(field)) {
-            case PIECE_PAWN: total_score += score_pawn(static_cast<field_t>(field_idx)); break;
-            case PIECE_KNIGHT: total_score += KNIGHT_SCORE * sign; break;
-            case PIECE_BISHOP: total_score += BISHOP_SCORE * sign; break;
-            case PIECE_ROOK: total_score += ROOK_SCORE * sign; break;
-            case PIECE_QUEEN: total_score += QUEEN_SCORE * sign; break;
+    for (const player_t player : { PLAYER_WHITE, PLAYER_BLACK }) {
+        score_t sign = (PLAYER_WHITE == player ? 1 : -1 );
+        for (uint8_t idx = 0; idx < pieces.counts[player]; ++idx) {
+            const field_t field_idx = pieces.fields[player][idx];
+            switch (field_get_piece(board[field_idx])) {
+                case PIECE_PAWN: total_score += score_pawn(field_idx); break;
+                case PIECE_KNIGHT: total_score += KNIGHT_SCORE * sign; break;
+                case PIECE_BISHOP: total_score += BISHOP_SCORE * sign; break;
+                case PIECE_ROOK: total_score += ROOK_SCORE * sign; break;
+                case PIECE_QUEEN: total_score += QUEEN_SCORE * sign; break;
+            }
         }
     }
-    total_score -= is_king_under_attack(board, PLAYER_WHITE) * 10;
-    total_score += is_king_under_attack(board, PLAYER_BLACK) * 10;
+    total_score -= is_king_under_attack(board, PLAYER_WHITE, pieces) * 10;
+    total_score += is_king_under_attack(board, PLAYER_BLACK, pieces) * 10;
     total_score += score_distr(score_gen);
     return total_score;
 }
 
 struct evaluation_s {
-    std::size_t index;
+    move_t move;
     score_t score;
 };
 
@@ -117,266 +114,134 @@ bool compare_score(const score_t score, const score_t best_score) {
 }
 
 struct cache_entry_t {
-    int depth = 0;
-    score_t score = 0;
-    score_t alpha = MIN_SCORE;
-    score_t beta = MAX_SCORE;
+    move_t best_move = MOVE_NONE;
 };
 
-std::unordered_map<board_state_t, cache_entry_t> cache;
+std::unordered_map<position_key_t, cache_entry_t> cache;
 int cache_hits = 0;
 
-struct cache_entry_2_t {
-    std::vector<board_state_t> candidates;
-};
-
-std::unordered_map<board_state_t, cache_entry_2_t> cache_2;
+using killer_moves_t = std::array<move_t, 2>;
+std::array<killer_moves_t, 16> killer_moves;
 
-board_state_t* gen_moves(
-    board_state_t* moves_beg, const board_state_t& board, const player_t player) {
-    if (cache_2.size() > 20'000'000) {
-        cache_2.clear();
+move_picker_t pick_moves(const board_state_t& board, const position_key_t key,
+    const player_t player, const int depth) {
+    if (cache.size() > 20'000'000) {
+        cache.clear();
     }
-    auto& entry = cache_2[board];
-    if (entry.candidates.size()) {
+    const move_t hash_move = cache[key].best_move;
+    if (MOVE_NONE != hash_move)
         ++cache_hits;
-        return std::copy(std::begin(entry.candidates), std::end(entry.candidates), moves_beg);
+    return make_move_picker(board, player, hash_move, killer_moves[depth]);
+}
+
+void store_cutoff(const position_key_t key, const move_picker_t& picker, const move_t move,
+    const int depth) {
+    cache[key].best_move = move;
+    if (picker.stage >= move_picker_stage_t::KILLERS and move != killer_moves[depth][0]) {
+        killer_moves[depth][1] = killer_moves[depth][0];
+        killer_moves[depth][0] = move;
     }
-    auto moves_end = fill_candidate_moves(moves_beg, board, opponent(player));
-    entry.candidates.reserve(moves_end - moves_beg);
-    std::copy(moves_beg, moves_end, std::back_inserter(entry.candidates));
-    return moves_end;
 }
 
-evaluation_s evaluate_position_min_AB(
-    const board_state_t* moves_beg, board_state_t* moves_end, const player_t player,
-    const int depth, const score_t beta);
+evaluation_s evaluate_position_min_AB(board_state_t& board, piece_list_t& pieces,
+    const position_key_t key, const player_t player, const int depth, const score_t beta);
 
-evaluation_s evaluate_position_max_AB(
-    const board_state_t* moves_beg, board_state_t* moves_end, const player_t player,
-    const int depth, const score_t alpha) {
-    auto score_f =
-        [depth, player](const board_state_t& board, board_state_t* moves_beg, const score_t beta) {
+evaluation_s evaluate_position_max_AB(board_state_t& board, piece_list_t& pieces,
+    const position_key_t key, const player_t player, const int depth, const score_t alpha) {
+    auto score_f = [depth, player](board_state_t& board, piece_list_t& pieces,
+        const position_key_t key, const score_t beta) {
         if (depth > 0) {
-            auto moves_end = gen_moves(moves_beg, board, opponent(player));
-
-            if (moves_beg == moves_end) {
-                if (is_king_under_attack(board, player))
-                    return -1000;
-                else if (is_king_under_attack(board, opponent(player)))
-                    return 1000;
-                else
-                    return 0;
-            }
-
             return evaluate_position_min_AB(
-                moves_beg, moves_end, opponent(player), depth - 1, beta).score;
+                board, pieces, key, opponent(player), depth - 1, beta).score;
         } else {
-            return score_position(board);
+            return score_position(board, pieces);
         }
     };
-    auto cached_score_f =
-        [&](const board_state_t& board, board_state_t* moves_beg, const score_t beta) {
-        auto& entry = cache[board];
-        if (entry.depth >= depth and entry.beta < beta) {
-            ++cache_hits;
-            return entry.score;
-        }
-        entry.depth = depth;
-        entry.alpha = MIN_SCORE;
-        entry.beta = beta;
-        return entry.score = score_f(board, moves_beg, beta);
-    };
 
-    std::size_t moves_cnt = moves_end - moves_beg;
-    std::size_t best_move_idx = 0;
+    auto picker = pick_moves(board, key, player, depth);
     print_tab(depth);
-    // minimax_stream << "MAX: " << moves_cnt << " candidate moves at depth " << depth << "\n";
-    score_t best_score = MIN_SCORE;
-    for (std::size_t idx = 0; idx < moves_cnt; ++idx) {
-        auto score = score_f(moves_beg[idx], moves_end, best_score);
+    evaluation_s best = { MOVE_NONE, MIN_SCORE };
+    for (move_t move = next_move(picker); MOVE_NONE != move; move = next_move(picker)) {
+        const position_key_t move_key = position_key_after_move(board, key, move);
+        undo_t undo;
+        make_move(board, move, undo, pieces);
+        auto score = score_f(board, pieces, move_key, best.score);
+        unmake_move(board, undo, pieces);
         print_tab(depth);
-        // minimax_stream << "MAX: move " << idx << " -> score " << score << '\n';
         if (depth and score >= alpha) {
             print_tab(depth);
             minimax_stream << "MAX: pruning on alpha = " << alpha << " at depth = " << depth << '\n';
-            return { idx, score };
-        }
-        if (compare_score(score, best_score)) {
-            best_score = score;
-            best_move_idx = idx;
+            store_cutoff(key, picker, move, depth);
+            return { move, score };
         }
+        if (MOVE_NONE == best.move or compare_score(score, best.score))
+            best = { move, score };
     }
-    print_tab(depth);
-    // minimax_stream << "MAX: chose move " << best_move_idx << " with score " << best_score << '\n';
-    return { best_move_idx, best_score };
+    if (MOVE_NONE == best.move)
+        return { MOVE_NONE, is_king_under_attack(board, player, pieces) ? -1000 : 0 };
+    cache[key].best_move = best.move;
+    return best;
 }
 
-evaluation_s evaluate_position_min_AB(
-    const board_state_t* moves_beg, board_state_t* moves_end, const player_t player,
-    const int depth, const score_t beta) {
-    auto score_f =
-        [depth, player](const board_state_t& board, board_state_t* moves_beg, const score_t alpha) {
+evaluation_s evaluate_position_min_AB(board_state_t& board, piece_list_t& pieces,
+    const position_key_t key, const player_t player, const int depth, const score_t beta) {
+    auto score_f = [depth, player](board_state_t& board, piece_list_t& pieces,
+        const position_key_t key, const score_t alpha) {
         if (depth > 0) {
-            auto moves_end = gen_moves(moves_beg, board, opponent(player));
-            if (moves_beg == moves_end) {
-                if (is_king_under_attack(board, player))
-                    return 1000;
-                else if (is_king_under_attack(board, opponent(player)))
-                    return -1000;
-                else
-                    return 0;
-            }
-
             return evaluate_position_max_AB(
-                moves_beg, moves_end, opponent(player), depth - 1, alpha).score;
+                board, pieces, key, opponent(player), depth - 1, alpha).score;
         } else {
-            return score_position(board);
+            return score_position(board, pieces);
         }
     };
-    auto cached_score_f =
-        [&](const board_state_t& board, board_state_t* moves_beg, const score_t alpha) {
-        auto& entry = cache[board];
-        if (entry.depth >= depth and entry.alpha > alpha) {
-            ++cache_hits;
-            return entry.score;
-        }
-        entry.depth = depth;
-        entry.alpha = alpha;
-        entry.beta = MAX_SCORE;
-        return entry.score = score_f(board, moves_beg, alpha);
-    };
 
-    std::size_t moves_cnt = moves_end - moves_beg;
-    std::size_t best_move_idx = 0;
+    auto picker = pick_moves(board, key, player, depth);
     print_tab(depth);
-    // minimax_stream << "MIN: " << moves_cnt << " candidate moves at depth " << depth << "\n";
-    score_t best_score = MAX_SCORE;
-    for (std::size_t idx = 0; idx < moves_cnt; ++idx) {
-        auto score = score_f(moves_beg[idx], moves_end, best_score);
+    evaluation_s best = { MOVE_NONE, MAX_SCORE };
+    for (move_t move = next_move(picker); MOVE_NONE != move; move = next_move(picker)) {
+        const position_key_t move_key = position_key_after_move(board, key, move);
+        undo_t undo;
+        make_move(board, move, undo, pieces);
+        auto score = score_f(board, pieces, move_key, best.score);
+        unmake_move(board, undo, pieces);
         print_tab(depth);
-        // minimax_stream << "MIN: move " << idx << " -> score " << score << '\n';
         if (depth and score <= beta) {
             print_tab(depth);
             minimax_stream << "MIN: pruning on beta = " << beta << " at depth = " << depth <<  '\n';
-            return { idx, score };
-        }
-        if (compare_score(best_score, score)) {
-            best_score = score;
-            best_move_idx = idx;
+            store_cutoff(key, picker, move, depth);
+            return { move, score };
         }
+        if (MOVE_NONE == best.move or compare_score(best.score, score))
+            best = { move, score };
     }
-    print_tab(depth);
-    // minimax_stream << "MIN: chose move " << best_move_idx << " with score " << best_score << '\n';
-    return { best_move_idx, best_score };
+    if (MOVE_NONE == best.move)
+        return { MOVE_NONE, is_king_under_attack(board, player, pieces) ? 1000 : 0 };
+    cache[key].best_move = best.move;
+    return best;
 }
 
-evaluation_s evaluate_position_min(
-    const board_state_t* moves_beg, board_state_t* moves_end, const player_t player,
-    const int depth);
-
-evaluation_s evaluate_position_max(
-    const board_state_t* moves_beg, board_state_t* moves_end, const player_t player,
-    const int depth) {
-    auto score_f = [depth, player](const board_state_t& board, board_state_t* moves_beg) {
-        if (depth > 0) {
-            auto moves_end = fill_candidate_moves(moves_beg, board, opponent(player));
-
-            if (moves_beg == moves_end) {
-                if (is_king_under_attack(board, player))
-                    return -100;
-                else if (is_king_under_attack(board, opponent(player)))
-                    return 100;
-                else
-                    return 0;
-            }
-
-            return evaluate_position_min(moves_beg, moves_end, opponent(player), depth - 1).score;
-        } else {
-            return score_position(board);
-        }
-    };
-
-    std::size_t moves_cnt = moves_end - moves_beg;
-    std::size_t best_move_idx = 0;
-    print_tab(depth);
-    printf("MAX: %ld candidate moves at depth %ld\n", moves_cnt, depth);
-    score_t best_score = score_f(moves_beg[0], moves_end);
-    for (std::size_t idx = 1; idx < moves_cnt; ++idx) {
-        auto score = score_f(moves_beg[idx], moves_end);
-        print_tab(depth);
-        printf("MAX: move %ld -> score %d\n", idx, score);
-        if (score > best_score) {
-            best_score = score;
-            best_move_idx = idx;
-        }
-    }
-    print_tab(depth);
-    printf("MAX: chose move %ld with score %d\n", best_move_idx, best_score);
-    return { best_move_idx, best_score };
-}
-
-evaluation_s evaluate_position_min(
-    const board_state_t* moves_beg, board_state_t* moves_end, const player_t player,
-    const int depth) {
-    auto score_f = [depth, player](const board_state_t& board, board_state_t* moves_beg) {
-        if (depth > 0) {
-            auto moves_end = fill_candidate_moves(moves_beg, board, opponent(player));
-            if (moves_beg == moves_end) {
-                if (is_king_under_attack(board, player))
-                    return 100;
-                else if (is_king_under_attack(board, opponent(player)))
-                    return -100;
-                else
-                    return 0;
-            }
-
-            return evaluate_position_max(moves_beg, moves_end, opponent(player), depth - 1).score;
-        } else {
-            return score_position(board);
-        }
-    };
-
-    std::size_t moves_cnt = moves_end - moves_beg;
-    std::size_t best_move_idx = 0;
-    print_tab(depth);
-    printf("MIN: %ld candidate moves at depth %ld\n", moves_cnt, depth);
-    score_t best_score = score_f(moves_beg[0], moves_end);
-    for (std::size_t idx = 1; idx < moves_cnt; ++idx) {
-        auto score = score_f(moves_beg[idx], moves_end);
-        print_tab(depth);
-        printf("MIN: move %ld -> score %d\n", idx, score);
-        if (score < best_score) {
-            best_score = score;
-            best_move_idx = idx;
-        }
-    }
-    print_tab(depth);
-    printf("MIN: chose move %ld with score %d\n", best_move_idx, best_score);
-    return { best_move_idx, best_score };
-}
-
-board_state_t* minimax_storage = nullptr;
-
 board_state_t minimax(
     const board_state_t& board, const player_t player, const int depth) {
-    cache_2.clear();
     cache_hits = 0;
-    auto moves_beg = minimax_storage;
-    auto moves_end = fill_candidate_moves(moves_beg, board, player);
+    killer_moves = {};
+    board_state_t hot_board = board;
+    piece_list_t pieces = make_piece_list(board);
+    const position_key_t key = position_key(board);
 
     if (PLAYER_WHITE == player) {
-        auto idx = evaluate_position_max_AB(moves_beg, moves_end, player, depth, MAX_SCORE).index;
-        return moves_beg[idx];
+        auto move =
+            evaluate_position_max_AB(hot_board, pieces, key, player, depth, MAX_SCORE).move;
+        return apply_move(board, move);
     } else {
-        auto idx = evaluate_position_min_AB(moves_beg, moves_end, player, depth, MIN_SCORE).index;
-        return moves_beg[idx];
+        auto move =
+            evaluate_position_min_AB(hot_board, pieces, key, player, depth, MIN_SCORE).move;
+        return apply_move(board, move);
     }
 }
 
 template <std::size_t DEPTH>
 game_action_t white_minimax(board_state_t& board) {
-    game_status << "Cache size: " << cache_2.size() << " | hits: " << cache_hits;
+    game_status << "Cache size: " << cache.size() << " | hits: " << cache_hits;
     chess::gui::print_board(layout, board);
     chess::gui::display(layout);
 
@@ -386,7 +251,7 @@ game_action_t white_minimax(board_state_t& board) {
 
 template <std::size_t DEPTH>
 game_action_t black_minimax(board_state_t& board) {
-    game_status << "Cache size: " << cache_2.size() << " | hits: " << cache_hits;
+    game_status << "Cache size: " << cache.size() << " | hits: " << cache_hits;
     chess::gui::print_board(layout, board);
     chess::gui::display(layout);
 
@@ -539,9 +404,7 @@ int main() {
 
     auto game_memory = prepare_game_memory();
     auto player_memory = prepare_game_memory();
-    auto minimax_memory = prepare_game_memory(intpow(64, 4));
     player_cm_storage = player_memory.get();
-    minimax_storage = minimax_memory.get();
 
     auto board = chess::START_BOARD;
     auto result = play(
@@ -0,0 +1,424 @@
+/** bitboard.hpp
+ *
+ * Chess engine bitboard position representation header-only library.
+ */
+#ifndef CHESS_BITBOARD_HPP_
+#define CHESS_BITBOARD_HPP_
+
+#include "chess/core.hpp"
+
+namespace chess
+{
+
+/** @defgroup bitboard-types Basic types of bitboard representation
+ *  @{
+ */
+
+/** Metadata of a bitboard position
+ *  Packed into a single aligned 64-bit word, so that each property is a plain byte or half-word
+ *  access and the whole header is copied with a single load and store, unlike `board_state_t` meta
+ *  bits which are spread over meta bits of 10 fields.
+ */
+struct alignas(8) position_header_t {
+    /** Last move made, same encoding as in `board_state_t` meta bits */
+    last_move_t last_move;
+    /** Player to make next move */
+    player_t side_to_move;
+    /** Castling rights, same encoding as in `board_state_t` meta bits */
+    castling_rights_t castling_rights;
+    /** `field_t` onto which en-passant capture can be made, `INVALID` if there is none */
+    uint8_t en_passant;
+    /** Number of moves made since the last capture or pawn move, saturates at 255 */
+    uint8_t halfmove_clock;
+};
+
+static_assert(8 == sizeof(position_header_t), "position_header_t has to fit a 64-bit word");
+
+/** Bitboard position type
+ *  Alternative to `board_state_t` position representation. Every piece type and every player has
+ *  a set of fields it occupies, so that board-wide queries are a handful of bitwise operations
+ *  instead of a scan over 64 fields. Fields under attack are not stored - they are computed on
+ *  demand from piece sets.
+ */
+struct bitboard_position_t {
+    /** Fields occupied by pieces of given type (any player), indexed with `piece_t` */
+    std::array<bitboard_t, PIECE_KING + 1> pieces;
+    /** Fields occupied by pieces of given player, indexed with `player_t` */
+    std::array<bitboard_t, 2> players;
+    /** Side to move, castling rights, en-passant field, halfmove clock and last move */
+    position_header_t header;
+};
+
+/*  @} */ // bitboard-types
+
+/** @defgroup bitboard-helpers Bitboard helper functions
+ *  @{
+ */
+
+/** Returns a set containing a single field */
+constexpr bitboard_t field_bit(const field_t field);
+
+/** Returns number of fields in a set */
+constexpr std::size_t bitboard_count(const bitboard_t bitboard);
+
+/** Returns the lowest field of non-empty set */
+constexpr field_t bitboard_first(const bitboard_t bitboard);
+
+/** Returns the lowest field of non-empty set and removes it from the set */
+constexpr field_t bitboard_pop_first(bitboard_t& bitboard);
+
+/*  @} */ // bitboard-helpers
+
+/** @defgroup bitboard-api Bitboard API functions
+ *  @{
+ */
+
+/** Converts `board_state_t` to bitboard representation
+ *
+ *  @param board - `board_state_t` which represents current position on the board.
+ *  @param player - Player to make next move. `board_state_t` does not store it, the same way as
+ *                  `fill_candidate_moves` requires it to be passed explicitly.
+ *  @param halfmove_clock - Number of moves made since the last capture or pawn move.
+ *                          `board_state_t` does not store it either.
+ *
+ *  @return `bitboard_position_t` describing the same position. En-passant field is derived from
+ *          last move stored in the metabits.
+ */
+bitboard_position_t make_bitboard_position(const board_state_t& board, const player_t player,
+    const uint8_t halfmove_clock = 0);
+
+/** Converts bitboard representation back to `board_state_t`
+ *
+ *  @param position - `bitboard_position_t` which represents current position on the board.
+ *
+ *  @return `board_state_t` with pieces, last move and castling rights of the position. Fields
+ *          under attack are recomputed, so the result can be passed directly to
+ *          `fill_candidate_moves`.
+ */
+board_state_t make_board_state(const bitboard_position_t& position);
+
+/** Fills bitboard positions with possible candidate moves of the side to move
+ *
+ * @param moves - Pointer to an array of `bitboard_position_t` elements to be written to. Available
+ *                memory has to be sufficient to store at least 220 candidate moves.
+ * @param position - `bitboard_position_t` which represents current position on the board.
+ *
+ * @return Pointer to element past the last filled out candidate move.
+ */
+bitboard_position_t* fill_candidate_moves(
+    bitboard_position_t* moves, const bitboard_position_t& position);
+
+/** Checks whether king of given player is attacked by any of the opponent's pieces */
+bool is_king_under_attack(const bitboard_position_t& position, const player_t player);
+
+/*  @} */ // bitboard-api
+
+/** @defgroup bitboard-private-impl Private implementation
+ *  @{
+ */
+namespace
+{
+
+constexpr bitboard_t BITBOARD_EMPTY = 0ull;
+constexpr bitboard_t BITBOARD_RANK_1 = 0x00000000000000FFull;
+constexpr bitboard_t BITBOARD_RANK_8 = 0xFF00000000000000ull;
+
+
+bitboard_t position_occupied(const bitboard_position_t& position) {
+    return position.players[PLAYER_WHITE] | position.players[PLAYER_BLACK];
+}
+
+bool is_field_attacked(
+    const bitboard_position_t& position, const field_t field, const player_t player) {
+    const bitboard_t attacker = position.players[player];
+    const bitboard_t occupied = position_occupied(position);
+    const bitboard_t diagonal = position.pieces[PIECE_BISHOP] | position.pieces[PIECE_QUEEN];
+    const bitboard_t cross = position.pieces[PIECE_ROOK] | position.pieces[PIECE_QUEEN];
+
+    return (PAWN_TARGETS[opponent(player)][field] &
+            position.pieces[PIECE_PAWN] & attacker) or
+        (KNIGHT_TARGETS[field] & position.pieces[PIECE_KNIGHT] & attacker) or
+        (KING_TARGETS[field] & position.pieces[PIECE_KING] & attacker) or
+        (bishop_attacks(field, occupied) & diagonal & attacker) or
+        (rook_attacks(field, occupied) & cross & attacker);
+}
+
+void position_remove_piece(bitboard_position_t& position, const field_t field) {
+    const bitboard_t mask = ~field_bit(field);
+    for (auto& pieces : position.pieces)
+        pieces &= mask;
+    position.players[PLAYER_WHITE] &= mask;
+    position.players[PLAYER_BLACK] &= mask;
+}
+
+void position_put_piece(bitboard_position_t& position, const field_t field, const piece_t piece,
+    const player_t player) {
+    position.pieces[piece] |= field_bit(field);
+    position.players[player] |= field_bit(field);
+}
+
+castling_rights_t position_castling_rights_after(castling_rights_t rights, const player_t player,
+    const piece_t piece, const field_t from, const field_t to) {
+    const bool white = PLAYER_WHITE == player;
+    if (PIECE_KING == piece) {
+        rights = white
+            ? castling_rights_remove_white_long(castling_rights_remove_white_short(rights))
+            : castling_rights_remove_black_long(castling_rights_remove_black_short(rights));
+    } else if (PIECE_ROOK == piece) {
+        if (from == (white ? A1 : A8))
+            rights = white
+                ? castling_rights_remove_white_long(rights)
+                : castling_rights_remove_black_long(rights);
+        else if (from == (white ? H1 : H8))
+            rights = white
+                ? castling_rights_remove_white_short(rights)
+                : castling_rights_remove_black_short(rights);
+    }
+
+    switch (to) {
+        case A1: return castling_rights_remove_white_long(rights);
+        case H1: return castling_rights_remove_white_short(rights);
+        case A8: return castling_rights_remove_black_long(rights);
+        case H8: return castling_rights_remove_black_short(rights);
+        default: return rights;
+    }
+}
+
+/** Writes position after the move to `*moves` and advances the pointer if the move is legal
+ *  @param promote_to - piece that pawn is promoted to or `PIECE_EMPTY`.
+ */
+bitboard_position_t* add_move_if_valid(
+    bitboard_position_t* moves, const bitboard_position_t& position, const piece_t piece,
+    const field_t from, const field_t to, const piece_t promote_to = PIECE_EMPTY) {
+    const player_t player = position.header.side_to_move;
+    auto& move = *moves = position;
+    const bool capture = position.players[opponent(player)] & field_bit(to);
+
+    position_remove_piece(move, to);
+    position_remove_piece(move, from);
+    position_put_piece(move, to, PIECE_EMPTY == promote_to ? piece : promote_to, player);
+
+    move.header.en_passant = field_t::INVALID;
+    if (PIECE_PAWN == piece) {
+        if (to == position.header.en_passant) {
+            position_remove_piece(move, PLAYER_WHITE == player ? field_down(to) : field_up(to));
+        } else if (16 == (from > to ? from - to : to - from)) {
+            move.header.en_passant = static_cast<uint8_t>((from + to) / 2);
+        }
+    } else if (PIECE_KING == piece and 2 == (from > to ? from - to : to - from)) {
+        const field_t rook_from = to > from ? field_right(to) : field_left(field_left(to));
+        const field_t rook_to = to > from ? field_left(to) : field_right(to);
+        position_remove_piece(move, rook_from);
+        position_put_piece(move, rook_to, PIECE_ROOK, player);
+    }
+
+    if (is_king_under_attack(move, player))
+        return moves;
+
+    const uint8_t halfmove_clock = position.header.halfmove_clock;
+    move.header.castling_rights =
+        position_castling_rights_after(position.header.castling_rights, player, piece, from, to);
+    move.header.last_move = last_move_set_to(last_move_set_from(last_move_set_piece(
+        last_move_set_player(last_move_t{}, player), piece), from), to);
+    move.header.side_to_move = opponent(player);
+    move.header.halfmove_clock = PIECE_PAWN == piece or capture
+        ? 0
+        : halfmove_clock + (UINT8_MAX != halfmove_clock);
+    return moves + 1;
+}
+
+bitboard_position_t* add_pawn_moves(
+    bitboard_position_t* moves, const bitboard_position_t& position, const field_t from,
+    bitboard_t targets) {
+    const bitboard_t promotion_rank = PLAYER_WHITE == position.header.side_to_move
+        ? BITBOARD_RANK_8
+        : BITBOARD_RANK_1;
+    while (targets) {
+        const field_t to = bitboard_pop_first(targets);
+        if (field_bit(to) & promotion_rank) {
+            for (const auto promote_to : { PIECE_KNIGHT, PIECE_BISHOP, PIECE_ROOK, PIECE_QUEEN })
+                moves = add_move_if_valid(moves, position, PIECE_PAWN, from, to, promote_to);
+        } else {
+            moves = add_move_if_valid(moves, position, PIECE_PAWN, from, to);
+        }
+    }
+    return moves;
+}
+
+bitboard_position_t* fill_pawn_candidate_moves(
+    bitboard_position_t* moves, const bitboard_position_t& position) {
+    const player_t player = position.header.side_to_move;
+    const bitboard_t empty = ~position_occupied(position);
+    bitboard_t capturable = position.players[opponent(player)];
+    if (field_t::INVALID != position.header.en_passant)
+        capturable |= field_bit(static_cast<field_t>(position.header.en_passant));
+
+    bitboard_t pawns = position.pieces[PIECE_PAWN] & position.players[player];
+    while (pawns) {
+        const field_t from = bitboard_pop_first(pawns);
+        const bitboard_t single = (PLAYER_WHITE == player
+            ? field_bit(from) << 8
+            : field_bit(from) >> 8) & empty;
+        bitboard_t targets = single | (PAWN_TARGETS[player][from] & capturable);
+        if (single and (PLAYER_WHITE == player
+            ? rank_t::_2 == field_rank(from)
+            : rank_t::_7 == field_rank(from))) {
+            targets |= (PLAYER_WHITE == player ? single << 8 : single >> 8) & empty;
+        }
+        moves = add_pawn_moves(moves, position, from, targets);
+    }
+    return moves;
+}
+
+template <typename attacks_f>
+bitboard_position_t* fill_piece_candidate_moves(
+    bitboard_position_t* moves, const bitboard_position_t& position, const piece_t piece,
+    attacks_f attacks) {
+    const player_t player = position.header.side_to_move;
+    bitboard_t pieces = position.pieces[piece] & position.players[player];
+    while (pieces) {
+        const field_t from = bitboard_pop_first(pieces);
+        bitboard_t targets = attacks(from) & ~position.players[player];
+        while (targets) {
+            moves = add_move_if_valid(moves, position, piece, from, bitboard_pop_first(targets));
+        }
+    }
+    return moves;
+}
+
+bitboard_position_t* fill_castle_candidate_moves(
+    bitboard_position_t* moves, const bitboard_position_t& position) {
+    const player_t player = position.header.side_to_move;
+    const player_t opp = opponent(player);
+    const bitboard_t occupied = position_occupied(position);
+    const bitboard_t rooks = position.pieces[PIECE_ROOK] & position.players[player];
+    const bool white = PLAYER_WHITE == player;
+    const field_t king = white ? E1 : E8;
+    const castling_rights_t rights = position.header.castling_rights;
+
+    if (not (position.pieces[PIECE_KING] & position.players[player] & field_bit(king)) or
+        is_field_attacked(position, king, opp))
+        return moves;
+
+    const field_t short_rook = white ? H1 : H8;
+    if ((white ? castling_rights_white_short(rights) : castling_rights_black_short(rights)) and
+        (rooks & field_bit(short_rook)) and
+        not (occupied & (field_bit(field_right(king)) | field_bit(field_left(short_rook)))) and
+        not is_field_attacked(position, field_right(king), opp)) {
+        moves = add_move_if_valid(moves, position, PIECE_KING, king, field_left(short_rook));
+    }
+
+    const field_t long_rook = white ? A1 : A8;
+    const field_t long_target = field_right(field_right(long_rook));
+    if ((white ? castling_rights_white_long(rights) : castling_rights_black_long(rights)) and
+        (rooks & field_bit(long_rook)) and
+        not (occupied & (field_bit(field_right(long_rook)) | field_bit(long_target) |
+            field_bit(field_left(king)))) and
+        not is_field_attacked(position, field_left(king), opp)) {
+        moves = add_move_if_valid(moves, position, PIECE_KING, king, long_target);
+    }
+    return moves;
+}
+
+}  // namespace
+
+/*  @} */ // bitboard-private-impl
+
+/** @defgroup bitboard-impl Implementation of public functions
+ *  @{
+ */
+
+constexpr bitboard_t field_bit(const field_t field) { return 1ull << field; }
+
+constexpr std::size_t bitboard_count(const bitboard_t bitboard) {
+    return __builtin_popcountll(bitboard);
+}
+
+constexpr field_t bitboard_first(const bitboard_t bitboard) {
+    return static_cast<field_t>(__builtin_ctzll(bitboard));
+}
+
+constexpr field_t bitboard_pop_first(bitboard_t& bitboard) {
+    const field_t field = bitboard_first(bitboard);
+    bitboard &= bitboard - 1;
+    return field;
+}
+
+bitboard_position_t make_bitboard_position(const board_state_t& board, const player_t player,
+    const uint8_t halfmove_clock) {
+    bitboard_position_t position = {};
+    for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
+         field_idx < static_cast<uint8_t>(field_t::END);
+         ++field_idx) {
+        const piece_t piece = field_get_piece(board[field_idx]);
+        if (PIECE_EMPTY == piece)
+            continue;
+        position_put_piece(position, static_cast<field_t>(field_idx), piece,
+            field_get_player(board[field_idx]));
+    }
+
+    position_header_t& header = position.header;
+    header.side_to_move = player;
+    header.castling_rights = board_state_meta_get_castling_rights(board);
+    header.last_move = board_state_meta_get_last_move(board);
+    header.en_passant = field_t::INVALID;
+    header.halfmove_clock = halfmove_clock;
+
+    const field_t from = last_move_get_from(header.last_move);
+    const field_t to = last_move_get_to(header.last_move);
+    if (PIECE_PAWN == last_move_get_piece(header.last_move) and
+        opponent(player) == last_move_get_player(header.last_move) and
+        16 == (from > to ? from - to : to - from)) {
+        header.en_passant = static_cast<uint8_t>((from + to) / 2);
+    }
+    return position;
+}
+
+board_state_t make_board_state(const bitboard_position_t& position) {
+    board_state_t board = EMPTY_BOARD;
+    for (piece_t piece = PIECE_PAWN; piece <= PIECE_KING; ++piece) {
+        bitboard_t fields = position.pieces[piece];
+        while (fields) {
+            const field_t field = bitboard_pop_first(fields);
+            const player_t player = (position.players[PLAYER_WHITE] & field_bit(field))
+                ? PLAYER_WHITE
+                : PLAYER_BLACK;
+            board[field] = field_set_piece(field_set_player(board[field], player), piece);
+        }
+    }
+    board_state_meta_set_last_move(board, position.header.last_move);
+    board_state_meta_set_castling_rights(board, position.header.castling_rights);
+    update_fields_under_attack(board);
+    return board;
+}
+
+bitboard_position_t* fill_candidate_moves(
+    bitboard_position_t* moves, const bitboard_position_t& position) {
+    const bitboard_t occupied = position_occupied(position);
+    moves = fill_pawn_candidate_moves(moves, position);
+    moves = fill_piece_candidate_moves(moves, position, PIECE_KNIGHT,
+        [](const field_t field) { return KNIGHT_TARGETS[field]; });
+    moves = fill_piece_candidate_moves(moves, position, PIECE_BISHOP,
+        [occupied](const field_t field) { return bishop_attacks(field, occupied); });
+    moves = fill_piece_candidate_moves(moves, position, PIECE_ROOK,
+        [occupied](const field_t field) { return rook_attacks(field, occupied); });
+    moves = fill_piece_candidate_moves(moves, position, PIECE_QUEEN,
+        [occupied](const field_t field) {
+            return bishop_attacks(field, occupied) | rook_attacks(field, occupied);
+        });
+    moves = fill_piece_candidate_moves(moves, position, PIECE_KING,
+        [](const field_t field) { return KING_TARGETS[field]; });
+    moves = fill_castle_candidate_moves(moves, position);
+    return moves;
+}
+
+bool is_king_under_attack(const bitboard_position_t& position, const player_t player) {
+    const bitboard_t king = position.pieces[PIECE_KING] & position.players[player];
+    return king and is_field_attacked(position, bitboard_first(king), opponent(player));
+}
+
+/*  @} */ // bitboard-impl
+
+}  // namespace chess
+
+#endif  // CHESS_BITBOARD_HPP_
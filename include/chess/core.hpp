@@ -5,8 +5,21 @@
 #ifndef CHESS_CORE_HPP_
 #define CHESS_CORE_HPP_
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+#if defined(__BMI2__) || (defined(__SSE2__) && !defined(CHESS_SIMD_NONE))
+#include <immintrin.h>
+#endif
+
+#ifdef CHESS_CHECK_ATTACK_MAP
+#include <cstdio>
+#include <cstdlib>
+#endif
 
 namespace chess
 {
@@ -49,6 +62,10 @@ using field_meta_bits_t = field_state_t;
 
 /** Basic board type
  *  Array of 64 fields from A1, B1 ... H8.
+ *  Move generation and making moves rely on attack bits of the fields. Moves update them only
+ *  around the moved pieces, so a board set up field by field has to have them computed once with
+ *  `update_fields_under_attack` before it is passed to API functions - otherwise they stay stale
+ *  in all the following positions.
  */
 using board_state_t = std::array<field_state_t, 64>;
 
@@ -103,6 +120,24 @@ enum class rank_t {
     END = MAX
 };
 
+/** Set of fields
+ *  Bit N of the set describes field N of `field_t` enumeration (A1 = bit 0, ..., H8 = bit 63).
+ */
+using bitboard_t = uint64_t;
+
+/** Zobrist key of a position
+ *  Xor of random keys of the pieces on their fields, castling rights, file of a pawn which can be
+ *  captured en passant and player to move. Positions which differ only in the attack map or in a
+ *  last move that allows no en passant capture have the same key.
+ */
+using position_key_t = uint64_t;
+
+/** Material signature of a position
+ *  Numbers of pawns, knights, bishops, rooks and queens of each player, 4 bits each, read with
+ *  `material_key_count`. Positions with the same key have exactly the same material.
+ */
+using material_key_t = uint64_t;
+
 /** Basic type describing a move on a chessboard */
 struct move_s {
     /** Which player made a move */
@@ -115,6 +150,129 @@ struct move_s {
     field_t to;
 };
 
+/** Compact move type
+ *  Describes a move in 16 bits - source field, destination field, promotion piece and move flags.
+ *  Moving piece and player are not stored, they are read from the board the move is applied to.
+ */
+using move_t = uint16_t;
+
+/** Move property - flags
+ *  Describes whether the move is a regular one, promotion, en-passant capture or castling.
+ */
+using move_flags_t = uint8_t;
+
+/** Legality checking mode of candidate moves generation */
+enum class generation_mode_t {
+    /** Every pseudo-legal move is applied and rejected if it leaves own king under attack */
+    VERIFY_APPLIED,
+    /** Checkers and pinned pieces are computed once per position and only legal moves are
+     *  emitted - evasions when in check, moves along the pin ray for pinned pieces */
+    PIN_AND_CHECK_AWARE
+};
+
+/** Undo information of a move made in place with `make_move`
+ *  Holds everything `unmake_move` needs to restore the previous position: states of the fields
+ *  changed by the move, attack bits flipped on other fields and meta state.
+ */
+struct undo_t {
+    /** Number of used entries in `fields` and `field_states` */
+    uint8_t fields_cnt;
+    /** Fields changed by the move */
+    std::array<field_t, 4> fields;
+    /** States of `fields` before the move */
+    std::array<field_state_t, 4> field_states;
+    /** Fields other than `fields` whose attack bits of each player were flipped by the move, bit N
+     *  describes field N */
+    std::array<uint64_t, 2> attack_flips;
+    /** Last move before the move */
+    last_move_t last_move;
+    /** Castling rights before the move */
+    castling_rights_t castling_rights;
+};
+
+/** Per-player lists of occupied fields
+ *  Optional index of a position kept next to `board_state_t`, which lets hot loops visit only the
+ *  fields of a player's pieces instead of all 64 fields. It is kept in sync by the `make_move` and
+ *  `unmake_move` overloads taking it, and recreated with `make_piece_list` when the position
+ *  changes in any other way.
+ */
+struct piece_list_t {
+    /** Fields of each player's pieces, indexed with `player_t`, first `counts` entries are valid */
+    std::array<std::array<field_t, 16>, 2> fields;
+    /** Number of pieces of each player, indexed with `player_t` */
+    std::array<uint8_t, 2> counts;
+    /** Field of each player's king, indexed with `player_t`, `field_t::INVALID` if there is none */
+    std::array<field_t, 2> kings;
+    /** Index of each occupied field in the list of its player */
+    std::array<uint8_t, 64> indices;
+};
+
+/** Number of legal moves of each piece type, indexed with `piece_t` */
+using piece_move_counts_t = std::array<uint16_t, 8>;
+
+namespace detail
+{
+
+/** Checkers and pinned pieces of a player's king, computed once per position */
+struct legal_info_s {
+    /** Field of the king */
+    field_t king;
+    /** Occupied fields of the position */
+    bitboard_t occupied;
+    /** Number of pieces giving check */
+    uint8_t checkers_cnt;
+    /** Fields which resolve a single check - checker and fields between ranged checker and king */
+    uint64_t evasion_mask;
+    /** Pinned pieces of the player */
+    uint64_t pinned_mask;
+    /** Fields from king up to the pinning piece, per direction of the pin (up, down, left, right,
+     *  left-up, right-down, right-up, left-down) */
+    std::array<uint64_t, 8> pin_rays;
+};
+
+}  // detail
+
+/** Sentinel ending iteration with `legal_move_iterator_t` */
+struct legal_moves_end_t {};
+
+/** Input iterator over legal moves of a position
+ *  Moves are generated one piece at a time, only once the moves of the previous piece are
+ *  exhausted, so iteration stopped early pays only for the pieces visited.
+ */
+struct legal_move_iterator_t {
+    /** Position to generate moves for, has to outlive the iterator */
+    const board_state_t* board;
+    /** Player to make one of the moves */
+    player_t player;
+    /** Own pieces whose moves were not generated yet */
+    bitboard_t pending_fields;
+    /** Occupied fields of each player, indexed with `player_t` */
+    std::array<bitboard_t, 2> fields;
+    /** Checkers and pins of the player's king */
+    detail::legal_info_s legal_info;
+    /** Index of the current move in `moves` */
+    uint8_t moves_idx;
+    /** Number of legal moves of the piece visited last */
+    uint8_t moves_cnt;
+    /** Legal moves of the piece visited last */
+    std::array<move_t, 32> moves;
+
+    move_t operator*() const;
+    legal_move_iterator_t& operator++();
+    bool operator!=(legal_moves_end_t) const;
+};
+
+/** Range of legal moves of a position, created with `legal_moves` */
+struct legal_moves_t {
+    /** Position to generate moves for, has to outlive the range */
+    const board_state_t* board;
+    /** Player to make one of the moves */
+    player_t player;
+
+    legal_move_iterator_t begin() const;
+    legal_moves_end_t end() const;
+};
+
 /*  @} */ // core-types
 
 /** @defgroup helpers Helper functions
@@ -157,6 +315,24 @@ constexpr field_t last_move_get_from(last_move_t last_move);
 constexpr last_move_t last_move_set_to(last_move_t last_move, field_t to);
 constexpr field_t last_move_get_to(last_move_t last_move);
 
+/** Move getters and setters */
+constexpr move_t move_set_from(move_t move, field_t from);
+constexpr field_t move_get_from(move_t move);
+
+constexpr move_t move_set_to(move_t move, field_t to);
+constexpr field_t move_get_to(move_t move);
+
+constexpr move_t move_set_flags(move_t move, move_flags_t flags);
+constexpr move_flags_t move_get_flags(move_t move);
+
+/** Sets promotion piece (knight, bishop, rook or queen) and promotion flag of a move */
+constexpr move_t move_set_promotion(move_t move, piece_t piece);
+/** Returns promotion piece of a move or `PIECE_EMPTY` if move is not a promotion */
+constexpr piece_t move_get_promotion(move_t move);
+
+/** Makes a `move_t` from source and destination fields */
+constexpr move_t encode_move(const field_t from, const field_t to, const move_flags_t flags);
+
 /** Castling rights manipulation */
 constexpr castling_rights_t castling_rights_remove_white_short(const castling_rights_t rights);
 constexpr bool castling_rights_white_short(const castling_rights_t rights);
@@ -257,25 +433,355 @@ constexpr castling_rights_t CASTLING_RIGHTS_WHITE_LONG = 0b0010;
 constexpr castling_rights_t CASTLING_RIGHTS_BLACK_SHORT = 0b0100;
 constexpr castling_rights_t CASTLING_RIGHTS_BLACK_LONG = 0b1000;
 
+/** Move flags property values */
+constexpr move_flags_t MOVE_FLAG_NONE =         0b00;
+constexpr move_flags_t MOVE_FLAG_PROMOTION =    0b01;
+constexpr move_flags_t MOVE_FLAG_EN_PASSANT =   0b10;
+constexpr move_flags_t MOVE_FLAG_CASTLING =     0b11;
+
+/** Null move value - never generated as a candidate move (source and destination are the same) */
+constexpr move_t MOVE_NONE = 0;
+
 /*  @} */ // core-defs
 
 /** @defgroup core-api Core API functions
  *  @{
  */
 
+/** Sets fields under attack of both players from scratch
+ *  Other API functions update attack bits only where a move changes them, so a board set up field
+ *  by field has to be passed through this function once before it is passed to them.
+ *
+ *  @param board - `board_state_t` with pieces placed. Attack bits of all its fields are replaced.
+ */
+constexpr void update_fields_under_attack(board_state_t& board);
+
 /** Fills board states with possible candidate moves in current postion for given player
  *
  * @param moves - Pointer to an array of `board_state_t` elements to be written to. Available
  *                memory has to be sufficient to store at least 120 candidate moves.
- * @param board - `board_state_t` which represents current position on the board.
+ * @param board - `board_state_t` which represents current position on the board, with fields
+ *                under attack up to date.
  * @param player - Player to make one of the candidate moves.
+ * @param mode - How legality of the moves is established. Both modes generate the same moves.
  *
  * @return Pointer to element past the last filled out candidate move. Number of generated
  *         candidate moves can be calculated with the pointer difference between passed `moves`
  *         argument and the return value.
  */
 board_state_t* fill_candidate_moves(board_state_t* moves, const board_state_t& board,
+    const player_t player, const generation_mode_t mode = generation_mode_t::PIN_AND_CHECK_AWARE);
+
+/** Fills compact moves with possible candidate moves in current postion for given player
+ *  Generates the same candidate moves as `fill_candidate_moves`, but writes 2 bytes per move
+ *  instead of whole `board_state_t`. Position after any of the moves can be derived with
+ *  `apply_move`.
+ *
+ * @param moves - Pointer to an array of `move_t` elements to be written to. Available memory has to
+ *                be sufficient to store at least 256 moves.
+ * @param board - `board_state_t` which represents current position on the board, with fields
+ *                under attack up to date.
+ * @param player - Player to make one of the candidate moves.
+ * @param mode - How legality of the moves is established. Both modes generate the same moves.
+ *
+ * @return Pointer to element past the last filled out candidate move.
+ */
+move_t* fill_move_list(move_t* moves, const board_state_t& board, const player_t player,
+    const generation_mode_t mode = generation_mode_t::PIN_AND_CHECK_AWARE);
+
+/** Fills candidate moves of player `P` known at compile time
+ *  Same as `fill_candidate_moves` with `player` argument, which dispatches to this function. Colour
+ *  of the moving pieces is a constant in the whole generator.
+ */
+template <player_t P>
+board_state_t* fill_candidate_moves(board_state_t* moves, const board_state_t& board,
+    const generation_mode_t mode = generation_mode_t::PIN_AND_CHECK_AWARE);
+
+/** Fills compact moves of player `P` known at compile time
+ *  Same as `fill_move_list` with `player` argument, which dispatches to this function.
+ */
+template <player_t P>
+move_t* fill_move_list(move_t* moves, const board_state_t& board,
+    const generation_mode_t mode = generation_mode_t::PIN_AND_CHECK_AWARE);
+
+/** Fills candidate moves which capture or promote
+ *  Generates only captures, en passant captures included, and promotions, capturing or not. Moves
+ *  are legal as in `fill_candidate_moves`, and quiet moves are not generated at all, which makes
+ *  this function suitable for quiescence search. Together with `fill_quiet_moves` it generates
+ *  exactly the candidate moves of `fill_candidate_moves`.
+ *
+ * @param moves - Pointer to an array of `board_state_t` or `move_t` elements to be written to.
+ *                Available memory has to be sufficient to store at least 256 moves.
+ * @param board - `board_state_t` which represents current position on the board.
+ * @param player - Player to make one of the candidate moves.
+ *
+ * @return Pointer to element past the last filled out candidate move.
+ */
+board_state_t* fill_capture_moves(board_state_t* moves, const board_state_t& board,
     const player_t player);
+move_t* fill_capture_moves(move_t* moves, const board_state_t& board, const player_t player);
+
+/** Fills candidate moves which neither capture nor promote
+ *  Counterpart of `fill_capture_moves`, generates the remaining candidate moves, castling
+ *  included.
+ */
+board_state_t* fill_quiet_moves(board_state_t* moves, const board_state_t& board,
+    const player_t player);
+move_t* fill_quiet_moves(move_t* moves, const board_state_t& board, const player_t player);
+
+/** Fills capturing and promoting moves of player `P` known at compile time
+ *  Same as `fill_capture_moves` with `player` argument, which dispatches to this function.
+ */
+template <player_t P>
+board_state_t* fill_capture_moves(board_state_t* moves, const board_state_t& board);
+template <player_t P>
+move_t* fill_capture_moves(move_t* moves, const board_state_t& board);
+
+/** Fills quiet moves of player `P` known at compile time
+ *  Same as `fill_quiet_moves` with `player` argument, which dispatches to this function.
+ */
+template <player_t P>
+board_state_t* fill_quiet_moves(board_state_t* moves, const board_state_t& board);
+template <player_t P>
+move_t* fill_quiet_moves(move_t* moves, const board_state_t& board);
+
+/** Returns position after a move
+ *  Fields under attack are updated only where the move changes them, stale ones stay stale.
+ *
+ *  @param board - `board_state_t` which represents current position on the board, with fields
+ *                 under attack up to date.
+ *  @param move - One of the candidate moves generated by `fill_move_list` for this position.
+ *
+ *  @return - `board_state_t` equal to the candidate move generated by `fill_candidate_moves`.
+ */
+board_state_t apply_move(const board_state_t& board, const move_t move);
+
+/** Makes a move in place
+ *  Alternative to `apply_move` for deep searches - position is updated in place instead of being
+ *  copied, and can be restored with `unmake_move`.
+ *
+ *  @param board - `board_state_t` which represents current position on the board, with fields
+ *                 under attack up to date. After the call it is equal to
+ *                 `apply_move(board, move)`.
+ *  @param move - One of the candidate moves generated by `fill_move_list` for this position.
+ *  @param undo - Filled out with information needed to unmake the move.
+ */
+void make_move(board_state_t& board, const move_t move, undo_t& undo);
+
+/** Restores position from before `make_move`
+ *  Moves have to be unmade in reverse order to the one they were made in.
+ *
+ *  @param board - `board_state_t` after the move.
+ *  @param undo - Undo information filled out by `make_move`.
+ */
+void unmake_move(board_state_t& board, const undo_t& undo);
+
+/** Creates lists of fields occupied by each player's pieces
+ *
+ *  @param board - `board_state_t` which represents current position on the board. Each player
+ *                 has at most 16 pieces on the board.
+ *
+ *  @return `piece_list_t` of the position.
+ */
+piece_list_t make_piece_list(const board_state_t& board);
+
+/** Makes a move in place, updating piece lists of the position
+ *  Same as `make_move` without `pieces` argument.
+ *
+ *  @param pieces - `piece_list_t` of `board`, after the call it describes the position after the
+ *                  move.
+ */
+void make_move(board_state_t& board, const move_t move, undo_t& undo, piece_list_t& pieces);
+
+/** Restores position and its piece lists from before `make_move`
+ *  Same as `unmake_move` without `pieces` argument.
+ */
+void unmake_move(board_state_t& board, const undo_t& undo, piece_list_t& pieces);
+
+/** Fills compact legal moves, with the king field read from piece lists
+ *  Same as `fill_move_list` in `PIN_AND_CHECK_AWARE` mode, without searching the board for the
+ *  king of `player`.
+ *
+ *  @param pieces - `piece_list_t` of `board`.
+ */
+move_t* fill_move_list(move_t* moves, const board_state_t& board, const player_t player,
+    const piece_list_t& pieces);
+
+/** Checks whether king of given player is attacked, with the king field read from piece lists
+ *  Reads attack bits of the king field only, instead of searching the board for the king.
+ *
+ *  @param pieces - `piece_list_t` of `board`.
+ */
+bool is_king_under_attack(const board_state_t& board, const player_t player,
+    const piece_list_t& pieces);
+
+/** Returns lazy range of legal moves of a position
+ *  Generates the same moves as `fill_move_list`, without a caller supplied buffer. Moves are
+ *  generated on demand, e.g. `for (const move_t move : legal_moves(board, player))` which breaks
+ *  out of the loop after the first few moves does not generate moves of the remaining pieces.
+ *
+ *  @param board - `board_state_t` which represents current position on the board. Has to outlive
+ *                 the range and its iterators.
+ *  @param player - Player to make one of the moves.
+ *
+ *  @return `legal_moves_t` range of `move_t`.
+ */
+legal_moves_t legal_moves(const board_state_t& board, const player_t player);
+
+/** Checks whether a player has any legal move
+ *  Stops at the first piece with a legal move, which makes checkmate and stalemate detection
+ *  much cheaper than generating all the moves.
+ *
+ *  @param board - `board_state_t` which represents current position on the board.
+ *  @param player - Player to make one of the moves.
+ *
+ *  @return `false` if the player is checkmated or stalemated, `true` otherwise.
+ */
+bool has_legal_move(const board_state_t& board, const player_t player);
+
+/** Counts legal moves of a player
+ *  Mobility term for evaluation functions - counts the moves of `fill_move_list` without writing
+ *  them anywhere. Moves of knights and ranged pieces are counted with popcounts of their target
+ *  fields restricted by pins and checks; only pawn and king moves are generated one by one, into
+ *  a buffer local to the function.
+ *
+ *  @param board - `board_state_t` which represents current position on the board.
+ *  @param player - Player to make one of the moves.
+ *
+ *  @return Number of legal moves, every promotion piece counted as a separate move.
+ */
+std::size_t count_legal_moves(const board_state_t& board, const player_t player);
+
+/** Counts legal moves of a player per type of the moving piece
+ *  Same as `count_legal_moves`, with the moves of each piece type counted separately.
+ *
+ *  @return `piece_move_counts_t` which adds up to `count_legal_moves`.
+ */
+piece_move_counts_t count_legal_moves_by_piece(const board_state_t& board, const player_t player);
+
+/** Static exchange evaluation of a move
+ *  Material outcome of the sequence of captures on the target field of `move`, in which both
+ *  players recapture with their least valuable attacker and either of them may stop capturing
+ *  when it would lose material. Ranged pieces behind other attackers - on the same line as a
+ *  rook, bishop, queen or pawn which already captured - join the sequence once the pieces in
+ *  front of them are gone. Pins and checks are not taken into account.
+ *
+ *  @param board - `board_state_t` which represents current position on the board.
+ *  @param move - One of the candidate moves generated by `fill_move_list` for this position.
+ *
+ *  @return Material won by the player making `move`, in centipawns - pawn 100, knight and bishop
+ *          300, rook 500, queen 900. Negative for captures losing material, 0 for castling.
+ */
+int see(const board_state_t& board, const move_t move);
+
+/** Checks whether a move gives check
+ *  Decides from the occupied fields after the move, without making it or updating the attack map -
+ *  the moved piece checks from its target field, or a ranged piece checks through a field vacated
+ *  by the move. Discovered checks by en passant, which vacates two fields, and checks given by the
+ *  rook of castling are detected as well.
+ *
+ *  @param board - `board_state_t` which represents current position on the board.
+ *  @param move - One of the candidate moves generated by `fill_move_list` for this position.
+ *
+ *  @return `true` if the opponent's king is attacked after the move.
+ */
+bool gives_check(const board_state_t& board, const move_t move);
+
+/** Returns Zobrist key of a position
+ *  Computed from all fields of the board, use `position_key_after_move` to update a key along a
+ *  sequence of moves. Player to move is the opponent of the player of last move stored in
+ *  metabits.
+ *
+ *  @param board - `board_state_t` which represents current position on the board.
+ *
+ *  @return `position_key_t` of the position.
+ */
+position_key_t position_key(const board_state_t& board);
+
+/** Returns Zobrist key of the position after a move
+ *  Updates `key` with the fields changed by the move only, in constant time.
+ *
+ *  @param board - `board_state_t` before the move.
+ *  @param key - `position_key_t` of `board`.
+ *  @param move - One of the candidate moves generated by `fill_move_list` for this position.
+ *
+ *  @return `position_key_t` equal to `position_key(apply_move(board, move))`.
+ */
+position_key_t position_key_after_move(const board_state_t& board, const position_key_t key,
+    const move_t move);
+
+/** Returns Zobrist key of the pawns of a position
+ *  Same as `position_key` restricted to pawns, for caching pawn structure evaluation. Castling
+ *  rights, en passant and player to move are not part of the key.
+ */
+position_key_t pawn_key(const board_state_t& board);
+
+/** Returns pawn key of the position after a move
+ *  As `position_key_after_move`, for `pawn_key`.
+ */
+position_key_t pawn_key_after_move(const board_state_t& board, const position_key_t key,
+    const move_t move);
+
+/** Returns material signature of a position
+ *
+ *  @param board - `board_state_t` which represents current position on the board.
+ *
+ *  @return `material_key_t` of the position.
+ */
+material_key_t material_key(const board_state_t& board);
+
+/** Returns material signature of the position after a move
+ *  Changes only with captures and promotions, in constant time.
+ *
+ *  @param board - `board_state_t` before the move.
+ *  @param key - `material_key_t` of `board`.
+ *  @param move - One of the candidate moves generated by `fill_move_list` for this position.
+ *
+ *  @return `material_key_t` equal to `material_key(apply_move(board, move))`.
+ */
+material_key_t material_key_after_move(const board_state_t& board, const material_key_t key,
+    const move_t move);
+
+/** Returns number of a player's pieces of one type stored in a material signature
+ *
+ *  @param key - `material_key_t` of a position.
+ *  @param player - Player owning the pieces.
+ *  @param piece - Type of the pieces, `PIECE_PAWN` to `PIECE_QUEEN`.
+ */
+constexpr uint8_t material_key_count(const material_key_t key, const player_t player,
+    const piece_t piece);
+
+/** Returns fields attacked by a bishop
+ *  Constant time table lookup, indexed with BMI2 `pext` instruction where the processor executes it
+ *  fast and with magic bitboard multiplication elsewhere. Tables are filled once at program
+ *  startup.
+ *
+ *  @param field - Field of the bishop.
+ *  @param occupied - Occupied fields on the board.
+ *
+ *  @return Fields on the diagonals of `field` up to and including the first occupied one in every
+ *          direction, regardless of the player occupying it.
+ */
+bitboard_t bishop_attacks(const field_t field, const bitboard_t occupied);
+
+/** Returns fields attacked by a rook
+ *  As `bishop_attacks`, for the rank and the file of `field`.
+ */
+bitboard_t rook_attacks(const field_t field, const bitboard_t occupied);
+
+/** Checks whether a field is attacked by a player
+ *  Probes outward from `field` - pawn diagonals, knight jumps, king adjacency and slider rays - and
+ *  stops at the first attacker found. Does not read the under attack bits, so the answer is valid
+ *  for positions without an up to date attack map as well.
+ *
+ *  @param board - `board_state_t` which represents current position on the board.
+ *  @param field - Field to check.
+ *  @param by - Attacking player.
+ *
+ *  @return `true` if any piece of `by` attacks `field`, regardless of the piece occupying it -
+ *          fields with pieces of `by` are attacked if the pieces are defended.
+ */
+bool is_square_attacked(const board_state_t& board, const field_t field, const player_t by);
 
 /** Checks whether current `board_state_t` is valid in terms of `last_move_t` stored in metabits.
  *
@@ -317,13 +823,8 @@ namespace std
 template <>
 struct hash<chess::board_state_t>
 {
-    // Fowler-Noll-Vo hash function
     size_t operator()(const chess::board_state_t& board) const {
-        size_t result = 2166136261;
-        for (const auto field : board) {
-            result = (result * 16777619) ^ field;
-        }
-        return result;
+        return chess::position_key(board);
     }
 };
 
@@ -446,53 +947,121 @@ constexpr bitfield::property_descriptor_s<field_meta_bits_t> META_BITS_LAST_MOVE
   */
 constexpr bitfield::property_descriptor_s<field_meta_bits_t> META_BITS_CASTLING_DESC = { 16, 4 };
 
+/** From property descriptor of move
+  * Occupies bits 0-5 of `move_t`
+  */
+constexpr bitfield::property_descriptor_s<move_t> MOVE_FROM_DESC = { 0, 6 };
+
+/** To property descriptor of move
+  * Occupies bits 6-11 of `move_t`
+  */
+constexpr bitfield::property_descriptor_s<move_t> MOVE_TO_DESC = { 6, 6 };
+
+/** Promotion piece property descriptor of move (0 - knight, 1 - bishop, 2 - rook, 3 - queen)
+  * Occupies bits 12-13 of `move_t`
+  */
+constexpr bitfield::property_descriptor_s<move_t> MOVE_PROMOTION_DESC = { 12, 2 };
+
+/** Flags property descriptor of move
+  * Occupies bits 14-15 of `move_t`
+  */
+constexpr bitfield::property_descriptor_s<move_t> MOVE_FLAGS_DESC = { 14, 2 };
+
 /*  @} */ // private-desc
 
-/** Sets value of a meta bits property in `board_state_t` */
+/** Loads 8 consecutive fields starting at `field_idx` as a single 64-bit word, field
+ *  `field_idx` in the lowest byte
+ *  On little-endian targets this is one unaligned load outside of constant evaluation.
+ */
+constexpr uint64_t board_state_load_fields(
+    const board_state_t& board, const std::size_t field_idx) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (not __builtin_is_constant_evaluated()) {
+        uint64_t fields = 0u;
+        std::memcpy(&fields, board.data() + field_idx, sizeof(fields));
+        return fields;
+    }
+#endif
+    return static_cast<uint64_t>(board[field_idx]) |
+        static_cast<uint64_t>(board[field_idx + 1]) << 8 |
+        static_cast<uint64_t>(board[field_idx + 2]) << 16 |
+        static_cast<uint64_t>(board[field_idx + 3]) << 24 |
+        static_cast<uint64_t>(board[field_idx + 4]) << 32 |
+        static_cast<uint64_t>(board[field_idx + 5]) << 40 |
+        static_cast<uint64_t>(board[field_idx + 6]) << 48 |
+        static_cast<uint64_t>(board[field_idx + 7]) << 56;
+}
+
+/** Stores 8 consecutive fields starting at `field_idx` from a single 64-bit word, inverse of
+ *  `board_state_load_fields` */
+constexpr void board_state_store_fields(
+    board_state_t& board, const std::size_t field_idx, const uint64_t fields) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (not __builtin_is_constant_evaluated()) {
+        std::memcpy(board.data() + field_idx, &fields, sizeof(fields));
+        return;
+    }
+#endif
+    board[field_idx] = static_cast<field_state_t>(fields);
+    board[field_idx + 1] = static_cast<field_state_t>(fields >> 8);
+    board[field_idx + 2] = static_cast<field_state_t>(fields >> 16);
+    board[field_idx + 3] = static_cast<field_state_t>(fields >> 24);
+    board[field_idx + 4] = static_cast<field_state_t>(fields >> 32);
+    board[field_idx + 5] = static_cast<field_state_t>(fields >> 40);
+    board[field_idx + 6] = static_cast<field_state_t>(fields >> 48);
+    board[field_idx + 7] = static_cast<field_state_t>(fields >> 56);
+}
+
+/** Mask of meta bits of 8 fields loaded with `board_state_load_fields` */
+constexpr uint64_t BOARD_STATE_META_BITS_MASK = 0xC0C0C0C0C0C0C0C0ull;
+
+/** Packs meta bits of 8 loaded fields, 2 bits per field, into 16 bits */
+constexpr uint16_t meta_bits_gather(const uint64_t fields) {
+    uint64_t bits = (fields & BOARD_STATE_META_BITS_MASK) >> 6;
+    bits = (bits | (bits >> 6)) & 0x000F000F000F000Full;
+    bits = (bits | (bits >> 12)) & 0x000000FF000000FFull;
+    return static_cast<uint16_t>(bits | (bits >> 24));
+}
+
+/** Spreads 16 bits into meta bits of 8 fields, inverse of `meta_bits_gather` */
+constexpr uint64_t meta_bits_scatter(const uint16_t value) {
+    uint64_t bits = value;
+    bits = (bits | (bits << 24)) & 0x000000FF000000FFull;
+    bits = (bits | (bits << 12)) & 0x000F000F000F000Full;
+    bits = (bits | (bits << 6)) & 0x0303030303030303ull;
+    return bits << 6;
+}
+
+/** Sets value of a meta bits property in `board_state_t`
+ *  Meta bits of the fields holding the property are spread from `value` at once and merged into
+ *  the fields read and written back as a single 64-bit word, instead of 2 bits at a time.
+ */
 template <typename T, typename U>
 constexpr void board_state_meta_set_bits(
     board_state_t& board, T value, const bitfield::property_descriptor_s<U> desc) {
-
     const auto field_meta_bits_width = FIELD_META_BITS_DESC.bit_width;
-    auto consume = [&](const auto bit_pos, const auto bit_width, const auto field_idx)
-    {
-        auto meta_bits = field_get_meta_bits(board[field_idx]);
-        auto value_to_set = bitfield::get_property(value, { 0u, bit_width });
-        meta_bits = bitfield::set_property(meta_bits, value_to_set, { bit_pos, bit_width });
-        board[field_idx] = field_set_meta_bits(board[field_idx], meta_bits);
-        value >>= bit_width;
-    };
-
     const auto start_field_idx = desc.bit_pos / field_meta_bits_width;
-    const auto end_field_idx = (desc.bit_pos + desc.bit_width) / field_meta_bits_width;
-
-    consume(desc.bit_pos % field_meta_bits_width,
-        field_meta_bits_width - (desc.bit_pos % field_meta_bits_width), start_field_idx);
-    for (auto field_idx = start_field_idx + 1; field_idx < end_field_idx - 1; ++field_idx) {
-        consume(0u, field_meta_bits_width, field_idx);
-    }
-    consume(0u, desc.bit_pos + desc.bit_width - (end_field_idx - 1) * field_meta_bits_width,
-        end_field_idx - 1);
-}
-
-/** Gets value of a meta bits property in `board_state_t` */
+    const auto shift = desc.bit_pos % field_meta_bits_width;
+    const uint32_t value_mask = (1u << desc.bit_width) - 1;
+    const uint32_t value_bits = static_cast<uint32_t>(value) & value_mask;
+    const uint64_t meta_bits = meta_bits_scatter(static_cast<uint16_t>(value_bits << shift));
+    const uint64_t mask = meta_bits_scatter(static_cast<uint16_t>(value_mask << shift));
+    const uint64_t fields = board_state_load_fields(board, start_field_idx);
+    board_state_store_fields(board, start_field_idx, (fields & ~mask) | meta_bits);
+}
+
+/** Gets value of a meta bits property in `board_state_t`
+ *  Fields holding the property are read as a single 64-bit word and their meta bits are packed
+ *  with a few shifts and masks, instead of being collected 2 bits at a time.
+ */
 template <typename T, typename U>
 constexpr T board_state_meta_get_bits(
     const board_state_t& board, const bitfield::property_descriptor_s<U> desc) {
-    T result = {};
     const auto field_meta_bits_width = FIELD_META_BITS_DESC.bit_width;
     const auto start_field_idx = desc.bit_pos / field_meta_bits_width;
-    const auto end_field_idx = (desc.bit_pos + desc.bit_width) / field_meta_bits_width;
-
-    auto field_shift_idx = 0u;
-    for (std::size_t field_idx = start_field_idx;
-         field_idx < end_field_idx;
-         ++field_idx, ++field_shift_idx) {
-        auto shift = field_shift_idx * field_meta_bits_width;
-        field_meta_bits_t meta_bits = field_get_meta_bits(board[field_idx]);
-        result |= meta_bits << shift;
-    }
-    return result;
+    const uint16_t meta_bits = meta_bits_gather(board_state_load_fields(board, start_field_idx));
+    return static_cast<T>(
+        (meta_bits >> (desc.bit_pos % field_meta_bits_width)) & ((1u << desc.bit_width) - 1));
 }
 
 bool check_last_move(const board_state_t& board, const move_s& move) {
@@ -519,485 +1088,1082 @@ bool is_king_under_attack(const board_state_t& board, const player_t player) {
     return false;
 }
 
-void clear_fields_under_attack(board_state_t& board) {
-    for (auto& field : board) {
-        field = field_clear_under_white_attack(field);
-        field = field_clear_under_black_attack(field);
-    }
-}
+/** Directions on the board, each followed by the opposite one */
+enum field_direction_t : uint8_t {
+    FIELD_DIRECTION_UP, FIELD_DIRECTION_DOWN, FIELD_DIRECTION_LEFT, FIELD_DIRECTION_RIGHT,
+    FIELD_DIRECTION_LEFT_UP, FIELD_DIRECTION_RIGHT_DOWN,
+    FIELD_DIRECTION_RIGHT_UP, FIELD_DIRECTION_LEFT_DOWN,
+    FIELD_DIRECTION_MAX, FIELD_DIRECTION_DIAGONAL_BEGIN = FIELD_DIRECTION_LEFT_UP
+};
 
-void update_field_under_attack(board_state_t& board, const field_t field, const player_t player) {
-    if (field_t::INVALID != field) {
-        if (PLAYER_WHITE == player) {
-            board[field] = field_set_under_white_attack(board[field]);
-        } else {
-            board[field] = field_set_under_black_attack(board[field]);
-        }
-    }
+constexpr field_direction_t direction_opposite(const field_direction_t direction) {
+    return static_cast<field_direction_t>(direction ^ 1u);
 }
 
-void update_pawn_fields_under_attack(
-    board_state_t& board, const field_t field, const player_t player) {
-    if (PLAYER_WHITE == player) {
-        update_field_under_attack(board, field_left_up(field), player);
-        update_field_under_attack(board, field_right_up(field), player);
-    } else {
-        update_field_under_attack(board, field_left_down(field), player);
-        update_field_under_attack(board, field_right_down(field), player);
-    }
-}
-
-void update_knight_fields_under_attack(
-    board_state_t& board, const field_t field, const player_t player) {
-    update_field_under_attack(board, field_up(field_left_up(field)), player);
-    update_field_under_attack(board, field_up(field_right_up(field)), player);
-    update_field_under_attack(board, field_left(field_left_up(field)), player);
-    update_field_under_attack(board, field_left(field_left_down(field)), player);
-    update_field_under_attack(board, field_down(field_left_down(field)), player);
-    update_field_under_attack(board, field_down(field_right_down(field)), player);
-    update_field_under_attack(board, field_right(field_right_up(field)), player);
-    update_field_under_attack(board, field_right(field_right_down(field)), player);
-}
-
-void update_ranged_fields_under_attack_op(
-    board_state_t& board, const field_t field, const player_t player,
-    field_t(*operation)(const field_t)) {
-    field_t target_field = field;
-    do {
-        target_field = operation(target_field);
-        if (field_t::INVALID == target_field) break;
-        if (PIECE_EMPTY == field_get_piece(board[target_field])) {
-            update_field_under_attack(board, target_field, player);
-            continue;
-        }
-        if (player != field_get_player(board[target_field])) {
-            update_field_under_attack(board, target_field, player);
-            break;
-        }
-        break;
-    } while (true);
+constexpr bool direction_diagonal(const field_direction_t direction) {
+    return FIELD_DIRECTION_DIAGONAL_BEGIN <= direction;
 }
 
-void update_diagonal_fields_under_attack(
-    board_state_t& board, const field_t field, const player_t player) {
-    update_ranged_fields_under_attack_op(board, field, player, field_left_up);
-    update_ranged_fields_under_attack_op(board, field, player, field_left_down);
-    update_ranged_fields_under_attack_op(board, field, player, field_right_up);
-    update_ranged_fields_under_attack_op(board, field, player, field_right_down);
+/** Direction goes towards higher field indices */
+constexpr bool direction_positive(const field_direction_t direction) {
+    return FIELD_DIRECTION_UP == direction or FIELD_DIRECTION_RIGHT == direction or
+        FIELD_DIRECTION_LEFT_UP == direction or FIELD_DIRECTION_RIGHT_UP == direction;
 }
 
-void update_cross_fields_under_attack(
-    board_state_t& board, const field_t field, const player_t player) {
-    update_ranged_fields_under_attack_op(board, field, player, field_up);
-    update_ranged_fields_under_attack_op(board, field, player, field_down);
-    update_ranged_fields_under_attack_op(board, field, player, field_right);
-    update_ranged_fields_under_attack_op(board, field, player, field_left);
-}
+using field_table_t = std::array<field_t, static_cast<uint8_t>(field_t::END)>;
 
-void update_king_fields_under_attack(
-    board_state_t& board, const field_t field, const player_t player) {
-    update_field_under_attack(board, field_up(field), player);
-    update_field_under_attack(board, field_right_up(field), player);
-    update_field_under_attack(board, field_right(field), player);
-    update_field_under_attack(board, field_right_down(field), player);
-    update_field_under_attack(board, field_down(field), player);
-    update_field_under_attack(board, field_left_down(field), player);
-    update_field_under_attack(board, field_left(field), player);
-    update_field_under_attack(board, field_left_up(field), player);
+/** Field reached from every field by moving `file_step` files and `rank_step` ranks */
+constexpr field_table_t make_field_table(const int8_t file_step, const int8_t rank_step) {
+    field_table_t result = {};
+    for (int8_t field_idx = 0; field_idx < static_cast<int8_t>(field_t::END); ++field_idx) {
+        const int8_t file = field_idx % 8 + file_step;
+        const int8_t rank = field_idx / 8 + rank_step;
+        result[field_idx] = (0 <= file and file < 8 and 0 <= rank and rank < 8)
+            ? static_cast<field_t>(rank * 8 + file)
+            : field_t::INVALID;
+    }
+    return result;
 }
 
-void update_fields_under_attack(board_state_t& board) {
-    clear_fields_under_attack(board);
-    for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
-         field_idx < static_cast<uint8_t>(field_t::END);
-         ++field_idx) {
-        field_t field = static_cast<field_t>(field_idx);
-        piece_t piece = field_get_piece(board[field]);
-        player_t player = field_get_player(board[field]);
-        switch (piece) {
-            case PIECE_EMPTY: break;
-            case PIECE_PAWN: update_pawn_fields_under_attack(board, field, player); break;
-            case PIECE_KNIGHT: update_knight_fields_under_attack(board, field, player); break;
-            case PIECE_BISHOP: update_diagonal_fields_under_attack(board, field, player); break;
-            case PIECE_ROOK: update_cross_fields_under_attack(board, field, player); break;
-            case PIECE_QUEEN:
-                update_diagonal_fields_under_attack(board, field, player);
-                update_cross_fields_under_attack(board, field, player);
-                break;
-            case PIECE_KING: update_king_fields_under_attack(board, field, player); break;
+/** Neighbouring field in every direction, `field_t::INVALID` at the edge of the board */
+constexpr std::array<field_table_t, FIELD_DIRECTION_MAX> FIELD_NEIGHBOURS = {
+    make_field_table(0, 1), make_field_table(0, -1),
+    make_field_table(-1, 0), make_field_table(1, 0),
+    make_field_table(-1, 1), make_field_table(1, -1),
+    make_field_table(1, 1), make_field_table(-1, -1),
+};
+
+/** Fields a knight jumps to from every field, `field_t::INVALID` outside of the board */
+constexpr std::array<field_table_t, 8> FIELD_KNIGHT_JUMPS = {
+    make_field_table(-1, 2), make_field_table(1, 2),
+    make_field_table(-2, 1), make_field_table(2, 1),
+    make_field_table(-2, -1), make_field_table(2, -1),
+    make_field_table(-1, -2), make_field_table(1, -2),
+};
+
+/** Set of fields reached from every field with any of `jumps` */
+template <std::size_t N>
+constexpr std::array<bitboard_t, 64> make_field_targets(
+    const std::array<field_table_t, N>& jumps) {
+    std::array<bitboard_t, 64> result = {};
+    for (uint8_t field_idx = 0; field_idx < 64; ++field_idx) {
+        for (const auto& jump : jumps) {
+            if (field_t::INVALID != jump[field_idx])
+                result[field_idx] |= 1ull << jump[field_idx];
         }
     }
+    return result;
 }
 
-void update_last_move(board_state_t& board, const move_s& move) {
-    last_move_t last_move = {};
-    last_move = last_move_set_player(last_move, move.player);
-    last_move = last_move_set_piece(last_move, move.piece);
-    last_move = last_move_set_from(last_move, move.from);
-    last_move = last_move_set_to(last_move, move.to);
-    board_state_meta_set_last_move(board, last_move);
-}
+/** Fields attacked by a knight standing on every field */
+constexpr std::array<bitboard_t, 64> KNIGHT_TARGETS = make_field_targets(FIELD_KNIGHT_JUMPS);
 
-void update_castling_rights(board_state_t& board, const move_s& move) {
-    if (PLAYER_WHITE == move.player) {
-        if (PIECE_KING == move.piece) {
-            castling_rights_t rights = board_state_meta_get_castling_rights(board);
-            rights = castling_rights_remove_white_long(rights);
-            rights = castling_rights_remove_white_short(rights);
-            board_state_meta_set_castling_rights(board, rights);
-        } else if (PIECE_ROOK == move.piece and rank_t::_1 == field_rank(move.from) and
-            (file_t::A == field_file(move.from) or file_t::H == field_file(move.from))) {
-            castling_rights_t rights = board_state_meta_get_castling_rights(board);
-            rights = (file_t::A == field_file(move.from)
-                ? castling_rights_remove_white_long(rights)
-                : castling_rights_remove_white_short(rights));
-            board_state_meta_set_castling_rights(board, rights);
-        }
-    } else {
-        if (PIECE_KING == move.piece) {
-            castling_rights_t rights = board_state_meta_get_castling_rights(board);
-            rights = castling_rights_remove_black_long(rights);
-            rights = castling_rights_remove_black_short(rights);
-            board_state_meta_set_castling_rights(board, rights);
-        } else if (PIECE_ROOK == move.piece and rank_t::_8 == field_rank(move.from) and
-            (file_t::A == field_file(move.from) or file_t::H == field_file(move.from))) {
-            castling_rights_t rights = board_state_meta_get_castling_rights(board);
-            rights = (file_t::A == field_file(move.from)
-                ? castling_rights_remove_black_long(rights)
-                : castling_rights_remove_black_short(rights));
-            board_state_meta_set_castling_rights(board, rights);
+/** Fields attacked by a king standing on every field */
+constexpr std::array<bitboard_t, 64> KING_TARGETS = make_field_targets(FIELD_NEIGHBOURS);
+
+/** Fields attacked by a pawn, indexed with `player_t` and pawn's field */
+constexpr std::array<std::array<bitboard_t, 64>, 2> PAWN_TARGETS = {
+    make_field_targets<2>({ FIELD_NEIGHBOURS[FIELD_DIRECTION_LEFT_DOWN],
+        FIELD_NEIGHBOURS[FIELD_DIRECTION_RIGHT_DOWN] }),
+    make_field_targets<2>({ FIELD_NEIGHBOURS[FIELD_DIRECTION_LEFT_UP],
+        FIELD_NEIGHBOURS[FIELD_DIRECTION_RIGHT_UP] }),
+};
+
+/** Fields on the ray from every field in every direction, excluding the field itself */
+constexpr std::array<std::array<bitboard_t, 64>, FIELD_DIRECTION_MAX> make_field_rays() {
+    std::array<std::array<bitboard_t, 64>, FIELD_DIRECTION_MAX> result = {};
+    for (uint8_t direction = 0; direction < FIELD_DIRECTION_MAX; ++direction) {
+        for (uint8_t field_idx = 0; field_idx < 64; ++field_idx) {
+            field_t target_field = FIELD_NEIGHBOURS[direction][field_idx];
+            while (field_t::INVALID != target_field) {
+                result[direction][field_idx] |= 1ull << target_field;
+                target_field = FIELD_NEIGHBOURS[direction][target_field];
+            }
         }
     }
+    return result;
 }
 
-board_state_t* apply_move_if_valid(board_state_t* moves, const move_s& move) {
-    auto& board = *moves;
-    board[move.from] = field_set_piece(board[move.from], PIECE_EMPTY);
-    board[move.to] = field_set_piece(field_set_player(board[move.to], move.player), move.piece);
+constexpr std::array<std::array<bitboard_t, 64>, FIELD_DIRECTION_MAX> FIELD_RAYS =
+    make_field_rays();
 
-    update_fields_under_attack(board);
-    if (not is_king_under_attack(board, move.player)) {
-        update_last_move(board, move);
-        update_castling_rights(board, move);
-        return moves + 1;
+/** Fields attacked along a ray up to and including the first occupied field */
+constexpr bitboard_t ray_attacks(const field_t field, const bitboard_t occupied,
+    const field_direction_t direction) {
+    bitboard_t result = 0u;
+    field_t target_field = FIELD_NEIGHBOURS[direction][field];
+    while (field_t::INVALID != target_field) {
+        result |= 1ull << target_field;
+        if ((occupied >> target_field) & 1u) break;
+        target_field = FIELD_NEIGHBOURS[direction][target_field];
     }
-    return moves;
+    return result;
 }
 
-board_state_t* promote_pawn_if_able(
-    board_state_t* moves, const move_s& move, const piece_t promote_to) {
-    const auto temp_moves = moves;
-    moves = apply_move_if_valid(moves, move);
-    if (moves != temp_moves) {
-        (*temp_moves)[move.to] = field_set_piece((*temp_moves)[move.to], promote_to);
+/** Clears `bits` in every field of the board
+ *  With AVX2 or SSE2 enabled the board is processed as two 256-bit or four 128-bit vectors.
+ */
+inline void board_state_clear_bits(board_state_t& board, const field_state_t bits) {
+#if defined(__AVX2__) && !defined(CHESS_SIMD_NONE)
+    const __m256i mask = _mm256_set1_epi8(static_cast<char>(~bits));
+    for (std::size_t field_idx = 0; field_idx < board.size(); field_idx += sizeof(__m256i)) {
+        auto* fields = reinterpret_cast<__m256i*>(board.data() + field_idx);
+        _mm256_storeu_si256(fields, _mm256_and_si256(_mm256_loadu_si256(fields), mask));
     }
-    return moves;
+#elif defined(__SSE2__) && !defined(CHESS_SIMD_NONE)
+    const __m128i mask = _mm_set1_epi8(static_cast<char>(~bits));
+    for (std::size_t field_idx = 0; field_idx < board.size(); field_idx += sizeof(__m128i)) {
+        auto* fields = reinterpret_cast<__m128i*>(board.data() + field_idx);
+        _mm_storeu_si128(fields, _mm_and_si128(_mm_loadu_si128(fields), mask));
+    }
+#else
+    for (auto& field : board)
+        field &= static_cast<field_state_t>(~bits);
+#endif
 }
 
-board_state_t* add_white_pawn_move_up(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    field_t target_field = field_up(field);
-    if (field_t::INVALID == target_field or PIECE_EMPTY != field_get_piece(board[target_field]))
-        return moves;
-
-    if (rank_t::_8 == field_rank(target_field)) {
-        *moves = board;
-        moves = promote_pawn_if_able(
-            moves, { PLAYER_WHITE, PIECE_PAWN, field, target_field }, PIECE_KNIGHT);
-
-        *moves = board;
-        moves = promote_pawn_if_able(
-            moves, { PLAYER_WHITE, PIECE_PAWN, field, target_field }, PIECE_BISHOP);
-
-        *moves = board;
-        moves = promote_pawn_if_able(
-            moves, { PLAYER_WHITE, PIECE_PAWN, field, target_field }, PIECE_ROOK);
+constexpr void clear_fields_under_attack(board_state_t& board) {
+    if (not __builtin_is_constant_evaluated()) {
+        board_state_clear_bits(board, static_cast<field_state_t>(
+            FIELD_UNDER_WHITE_ATTACK_DESC.mask | FIELD_UNDER_BLACK_ATTACK_DESC.mask));
+        return;
+    }
+    for (auto& field : board) {
+        field = field_clear_under_white_attack(field);
+        field = field_clear_under_black_attack(field);
+    }
+}
 
-        *moves = board;
-        moves = promote_pawn_if_able(
-            moves, { PLAYER_WHITE, PIECE_PAWN, field, target_field }, PIECE_QUEEN);
-        return moves;
+template <player_t P>
+constexpr void update_field_under_attack(
+    board_state_t& board, const field_t field) {
+    if (PLAYER_WHITE == P) {
+        board[field] = field_set_under_white_attack(board[field]);
     } else {
-        *moves = board;
-        return apply_move_if_valid(moves, { PLAYER_WHITE, PIECE_PAWN, field, target_field });
+        board[field] = field_set_under_black_attack(board[field]);
     }
 }
 
-board_state_t* add_white_pawn_move_up_long(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    if (rank_t::_2 != field_rank(field)) return moves;
-    field_t target_field = field_up(field);
-    if (field_t::INVALID == target_field or PIECE_EMPTY != field_get_piece(board[target_field]))
-        return moves;
-    target_field = field_up(target_field);
-    if (field_t::INVALID == target_field or PIECE_EMPTY != field_get_piece(board[target_field]))
-        return moves;
+template <player_t P>
+constexpr void update_target_fields_under_attack(
+    board_state_t& board, bitboard_t target_fields) {
+    for (; target_fields; target_fields &= target_fields - 1) {
+        update_field_under_attack<P>(
+            board, static_cast<field_t>(__builtin_ctzll(target_fields)));
+    }
+}
 
-    *moves = board;
-    return apply_move_if_valid(moves, { PLAYER_WHITE, PIECE_PAWN, field, target_field });
+template <player_t P>
+constexpr void update_pawn_fields_under_attack(
+    board_state_t& board, const field_t field) {
+    update_target_fields_under_attack<P>(board, PAWN_TARGETS[P][field]);
 }
 
-board_state_t* add_white_pawn_capture_left_up(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    field_t target_field = field_left_up(field);
-    if (field_t::INVALID == target_field or
-        PIECE_EMPTY == field_get_piece(board[target_field]) or
-        PLAYER_BLACK != field_get_player(board[target_field]))
-        return moves;
+template <player_t P>
+constexpr void update_knight_fields_under_attack(
+    board_state_t& board, const field_t field) {
+    update_target_fields_under_attack<P>(board, KNIGHT_TARGETS[field]);
+}
 
-    *moves = board;
-    return apply_move_if_valid(moves, { PLAYER_WHITE, PIECE_PAWN, field, target_field });
+template <player_t P>
+constexpr void update_ranged_fields_under_attack(
+    board_state_t& board, const field_t field, const field_direction_t direction) {
+    for (field_t target_field = FIELD_NEIGHBOURS[direction][field];
+         field_t::INVALID != target_field;
+         target_field = FIELD_NEIGHBOURS[direction][target_field]) {
+        if (PIECE_EMPTY != field_get_piece(board[target_field])) {
+            if (P != field_get_player(board[target_field]))
+                update_field_under_attack<P>(board, target_field);
+            break;
+        }
+        update_field_under_attack<P>(board, target_field);
+    }
 }
 
-board_state_t* add_white_pawn_capture_right_up(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    field_t target_field = field_right_up(field);
-    if (field_t::INVALID == target_field or
-        PIECE_EMPTY == field_get_piece(board[target_field]) or
-        PLAYER_BLACK != field_get_player(board[target_field]))
-        return moves;
+template <player_t P>
+constexpr void update_diagonal_fields_under_attack(
+    board_state_t& board, const field_t field) {
+    update_ranged_fields_under_attack<P>(board, field, FIELD_DIRECTION_LEFT_UP);
+    update_ranged_fields_under_attack<P>(board, field, FIELD_DIRECTION_RIGHT_DOWN);
+    update_ranged_fields_under_attack<P>(board, field, FIELD_DIRECTION_RIGHT_UP);
+    update_ranged_fields_under_attack<P>(board, field, FIELD_DIRECTION_LEFT_DOWN);
+}
+
+template <player_t P>
+constexpr void update_cross_fields_under_attack(
+    board_state_t& board, const field_t field) {
+    update_ranged_fields_under_attack<P>(board, field, FIELD_DIRECTION_UP);
+    update_ranged_fields_under_attack<P>(board, field, FIELD_DIRECTION_DOWN);
+    update_ranged_fields_under_attack<P>(board, field, FIELD_DIRECTION_LEFT);
+    update_ranged_fields_under_attack<P>(board, field, FIELD_DIRECTION_RIGHT);
+}
+
+template <player_t P>
+constexpr void update_king_fields_under_attack(
+    board_state_t& board, const field_t field) {
+    update_target_fields_under_attack<P>(board, KING_TARGETS[field]);
+}
+
+template <player_t P>
+constexpr void update_piece_fields_under_attack(
+    board_state_t& board, const field_t field, const piece_t piece) {
+    switch (piece) {
+        case PIECE_EMPTY: break;
+        case PIECE_PAWN: update_pawn_fields_under_attack<P>(board, field); break;
+        case PIECE_KNIGHT: update_knight_fields_under_attack<P>(board, field); break;
+        case PIECE_BISHOP: update_diagonal_fields_under_attack<P>(board, field); break;
+        case PIECE_ROOK: update_cross_fields_under_attack<P>(board, field); break;
+        case PIECE_QUEEN:
+            update_diagonal_fields_under_attack<P>(board, field);
+            update_cross_fields_under_attack<P>(board, field);
+            break;
+        case PIECE_KING: update_king_fields_under_attack<P>(board, field); break;
+    }
+}
 
-    *moves = board;
-    return apply_move_if_valid(moves, { PLAYER_WHITE, PIECE_PAWN, field, target_field });
+constexpr board_state_t make_board_state_under_attack(board_state_t board) {
+    update_fields_under_attack(board);
+    return board;
 }
 
-board_state_t* add_white_pawn_capture_enpassant_left(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    if (rank_t::_5 != field_rank(field)) return moves;
+/** Magic bitboard of a slider on one field
+ *  Occupancy of `mask` fields multiplied by `magic` gives in its top bits a unique index of the
+ *  attack set within the slider's table, starting at `offset`.
+ */
+struct slider_magic_s {
+    bitboard_t mask;
+    bitboard_t magic;
+    uint8_t shift;
+    uint32_t offset;
+};
 
-    field_t target_field = field_left_up(field);
-    field_t opps_move_from = field_up(target_field);
-    field_t opps_move_to = field_down(target_field);
-    if (!check_last_move(board, { PLAYER_BLACK, PIECE_PAWN, opps_move_from, opps_move_to }))
-        return moves;
+/** Slider magic bitboards for all fields
+ *  Masks contain fields on the slider's rays without the last one - whether the edge of the board
+ *  is occupied does not change the attacks.
+ */
+constexpr std::array<slider_magic_s, 64> make_slider_magics(
+    const std::array<bitboard_t, 64>& magics, const bool diagonal, const uint32_t offset) {
+    std::array<slider_magic_s, 64> result = {};
+    uint32_t next_offset = offset;
+    for (uint8_t field_idx = 0; field_idx < 64; ++field_idx) {
+        bitboard_t mask = 0u;
+        for (uint8_t direction = 0; direction < FIELD_DIRECTION_MAX; ++direction) {
+            if (direction_diagonal(static_cast<field_direction_t>(direction)) != diagonal)
+                continue;
+            const bitboard_t ray = FIELD_RAYS[direction][field_idx];
+            if (0u == ray) continue;
+            const field_t last_field = direction_positive(static_cast<field_direction_t>(direction))
+                ? static_cast<field_t>(63 - __builtin_clzll(ray))
+                : static_cast<field_t>(__builtin_ctzll(ray));
+            mask |= ray & ~(1ull << last_field);
+        }
+        const auto bits = static_cast<uint8_t>(__builtin_popcountll(mask));
+        result[field_idx] = { mask, magics[field_idx], static_cast<uint8_t>(64 - bits),
+            next_offset };
+        next_offset += 1u << bits;
+    }
+    return result;
+}
+
+constexpr std::array<bitboard_t, 64> BISHOP_MAGIC_NUMBERS = {
+    0x0c08081028882700ull, 0x0208088820424040ull, 0x2188480100202561ull,
+    0x0004104610800140ull, 0x9004504100002000ull, 0x0a010108c0010041ull,
+    0x3800491028200000ull, 0x0000802101202002ull, 0x81020410b0810100ull,
+    0x0408082808404040ull, 0x0106220084008008ull, 0x0040182841001082ull,
+    0x158404504000800eull, 0x0888810108432808ull, 0x0100020811180808ull,
+    0x0801420a02410400ull, 0x1320559102103101ull, 0x0182002002240102ull,
+    0xa910000200260020ull, 0x0008010628210000ull, 0x8002000402114461ull,
+    0x0000204410080800ull, 0x0400500205100900ull, 0x2002014880840100ull,
+    0x01e1100108102148ull, 0x0410090044115400ull, 0x4004084010104040ull,
+    0x0202002008008220ull, 0x0001001105004020ull, 0x0001081022080400ull,
+    0x2018842000820806ull, 0x40008e0000210401ull, 0x2314104102082200ull,
+    0x0002100500101109ull, 0x1224040201411200ull, 0x0202004040040102ull,
+    0x0040002022020080ull, 0x2020004081210080ull, 0x0442020404004401ull,
+    0x0408c08a00090104ull, 0x0898a21821004003ull, 0xb004189210424820ull,
+    0x8008131088031000ull, 0x0009010148010500ull, 0x2100084104000040ull,
+    0x110102108200a100ull, 0x0010120801144060ull, 0x0002020a24200200ull,
+    0x0020880808040000ull, 0x0a8b041201040103ull, 0x0140120205114002ull,
+    0x6282000242021201ull, 0x080080140d0c0122ull, 0x0181102011810200ull,
+    0x0804041032420400ull, 0x0020842c00414142ull, 0x06498028010c2082ull,
+    0x0062202084042010ull, 0x8100000211008800ull, 0x6000000000840400ull,
+    0x0018000008210100ull, 0x00040011a0010100ull, 0x0820090210020204ull,
+    0x0402482804858200ull
+};
+
+constexpr std::array<bitboard_t, 64> ROOK_MAGIC_NUMBERS = {
+    0x9880004000102080ull, 0x9040001000200041ull, 0x1100200010400900ull,
+    0x2080080005801000ull, 0x0200041020080200ull, 0x0200041041084200ull,
+    0x0400080081124410ull, 0x2180042100004080ull, 0x8000800099644000ull,
+    0x0802003040820100ull, 0x0105801001862000ull, 0x0101002008100100ull,
+    0x1000800400080080ull, 0x0804800200040080ull, 0x2001800200800900ull,
+    0x00160004088204c1ull, 0x228000c001402000ull, 0x8510004000200050ull,
+    0x3001848020029000ull, 0x0280808010000801ull, 0x0109010010040800ull,
+    0x8000808004000200ull, 0x8000040081021028ull, 0x40040a0009004884ull,
+    0x80c0004280008035ull, 0x0010004040002000ull, 0x1101200500410070ull,
+    0x8410100080080080ull, 0x000c080080800400ull, 0x4012008080040002ull,
+    0x4000040101000200ull, 0x0061010200008044ull, 0x0080804010800020ull,
+    0x3000201008400040ull, 0x4112008012002444ull, 0x0848000880801000ull,
+    0x00a8008008800400ull, 0x200200280a00500cull, 0x080a221024004801ull,
+    0xc400008042000104ull, 0x8000400080028022ull, 0x0220008040018020ull,
+    0x4000200011010040ull, 0x10060040210a0010ull, 0x40820020904a0004ull,
+    0x0030040002008080ull, 0x0200020801840010ull, 0x0084c04100820004ull,
+    0x4802010080c2a600ull, 0x0000400080201880ull, 0x2040801000200080ull,
+    0x0180200842001200ull, 0x0013510008000500ull, 0x0182000c00808a80ull,
+    0x1000524821302400ull, 0x3800040108488200ull, 0x104a004810210082ull,
+    0x0004210010420082ull, 0xc424110008200241ull, 0x90101000a0088501ull,
+    0x0182000420100802ull, 0x4822001001080402ull, 0x05d0080090012204ull,
+    0x2008140089042846ull
+};
+
+constexpr std::array<slider_magic_s, 64> BISHOP_MAGICS =
+    make_slider_magics(BISHOP_MAGIC_NUMBERS, true, 0u);
 
-    *moves = board;
-    (*moves)[opps_move_to] = field_set_piece((*moves)[opps_move_to], PIECE_EMPTY);
-    return apply_move_if_valid(moves, { PLAYER_WHITE, PIECE_PAWN, field, target_field });
+constexpr std::array<slider_magic_s, 64> ROOK_MAGICS =
+    make_slider_magics(ROOK_MAGIC_NUMBERS, false,
+        BISHOP_MAGICS[63].offset + (1u << (64 - BISHOP_MAGICS[63].shift)));
+
+constexpr std::size_t SLIDER_ATTACKS_SIZE =
+    ROOK_MAGICS[63].offset + (1u << (64 - ROOK_MAGICS[63].shift));
+
+/** Way of turning occupied fields into an index of the slider attack table */
+enum class slider_index_t {
+    /** Multiplication by a magic number - portable */
+    MAGIC,
+    /** Parallel bit extraction of BMI2 - fast on Intel since Haswell and on AMD since Zen 3 */
+    PEXT,
+    /** One of the above, picked by CPUID at startup */
+    DETECTED
+};
+
+/** Gathers bits of `source` selected by `mask` into the low bits of the result
+ *  Executes `pext` instruction on x86-64, it may only be called once BMI2 support was checked.
+ *  Elsewhere the bits are extracted one by one.
+ */
+inline uint64_t bits_extract(const uint64_t source, uint64_t mask) {
+#if defined(__BMI2__)
+    return _pext_u64(source, mask);
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    uint64_t result;
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(source), "rm"(mask));
+    return result;
+#else
+    uint64_t result = 0u;
+    for (uint64_t bit = 1u; mask; mask &= mask - 1, bit <<= 1) {
+        if (source & mask & -mask)
+            result |= bit;
+    }
+    return result;
+#endif
 }
 
-board_state_t* add_white_pawn_capture_enpassant_right(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    if (rank_t::_5 != field_rank(field)) return moves;
+/** Picks the slider attack table index at startup
+ *  Building with BMI2 enabled (-mbmi2, -march=haswell...) makes PEXT the only choice, defining
+ *  CHESS_SLIDER_INDEX_MAGIC turns it off. Otherwise CPUID decides, skipping AMD processors which
+ *  execute `pext` in microcode.
+ */
+slider_index_t detect_slider_index() {
+#if defined(CHESS_SLIDER_INDEX_MAGIC)
+    return slider_index_t::MAGIC;
+#elif defined(__BMI2__)
+    return slider_index_t::PEXT;
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("bmi2") and not __builtin_cpu_is("bdver4") and
+        not __builtin_cpu_is("znver1") and not __builtin_cpu_is("znver2"))
+        return slider_index_t::PEXT;
+    return slider_index_t::MAGIC;
+#else
+    return slider_index_t::MAGIC;
+#endif
+}
+
+/** Slider attack table index of lookups
+ *  Fixed at build time by CHESS_SLIDER_INDEX_MAGIC or BMI2 enabled in the compiler, so that
+ *  lookups do not check which index is in use. Otherwise left to `detect_slider_index`.
+ */
+#if defined(CHESS_SLIDER_INDEX_MAGIC)
+constexpr slider_index_t SLIDER_INDEX = slider_index_t::MAGIC;
+#elif defined(__BMI2__)
+constexpr slider_index_t SLIDER_INDEX = slider_index_t::PEXT;
+#else
+constexpr slider_index_t SLIDER_INDEX = slider_index_t::DETECTED;
+#endif
+
+/** Attack sets of sliders for every field and every relevant occupancy, filled once at startup
+ *  @param INDEX - Index of the table. With `DETECTED` every lookup checks `index_kind`.
+ */
+template <slider_index_t INDEX>
+struct slider_attacks_s {
+    slider_index_t index_kind;
+    std::array<bitboard_t, SLIDER_ATTACKS_SIZE> attacks;
+
+    /** @param index_kind - Index of the table, only used with `DETECTED` `INDEX`. */
+    explicit slider_attacks_s(const slider_index_t index_kind = INDEX) : index_kind(index_kind) {
+        fill(BISHOP_MAGICS, true);
+        fill(ROOK_MAGICS, false);
+    }
 
-    field_t target_field = field_right_up(field);
-    field_t opps_move_from = field_up(target_field);
-    field_t opps_move_to = field_down(target_field);
-    if (!check_last_move(board, { PLAYER_BLACK, PIECE_PAWN, opps_move_from, opps_move_to }))
-        return moves;
+    uint32_t index(const slider_magic_s& magic, const bitboard_t occupied) const {
+        if constexpr (slider_index_t::PEXT == INDEX)
+            return magic.offset + static_cast<uint32_t>(bits_extract(occupied, magic.mask));
+        else if constexpr (slider_index_t::MAGIC == INDEX)
+            return magic.offset +
+                static_cast<uint32_t>(((occupied & magic.mask) * magic.magic) >> magic.shift);
+        else
+            return slider_index_t::PEXT == index_kind
+                ? magic.offset + static_cast<uint32_t>(bits_extract(occupied, magic.mask))
+                : magic.offset +
+                    static_cast<uint32_t>(((occupied & magic.mask) * magic.magic) >> magic.shift);
+    }
+
+    void fill(const std::array<slider_magic_s, 64>& magics, const bool diagonal) {
+        for (uint8_t field_idx = 0; field_idx < 64; ++field_idx) {
+            const auto field = static_cast<field_t>(field_idx);
+            const bitboard_t mask = magics[field_idx].mask;
+            bitboard_t occupied = 0u;
+            do {
+                bitboard_t result = 0u;
+                for (uint8_t direction = 0; direction < FIELD_DIRECTION_MAX; ++direction) {
+                    const auto ray_direction = static_cast<field_direction_t>(direction);
+                    if (direction_diagonal(ray_direction) == diagonal)
+                        result |= ray_attacks(field, occupied, ray_direction);
+                }
+                attacks[index(magics[field_idx], occupied)] = result;
+                occupied = (occupied - mask) & mask;
+            } while (0u != occupied);
+        }
+    }
+
+    bitboard_t bishop(const field_t field, const bitboard_t occupied) const {
+        return attacks[index(BISHOP_MAGICS[field], occupied)];
+    }
+
+    bitboard_t rook(const field_t field, const bitboard_t occupied) const {
+        return attacks[index(ROOK_MAGICS[field], occupied)];
+    }
+};
 
-    *moves = board;
-    (*moves)[opps_move_to] = field_set_piece((*moves)[opps_move_to], PIECE_EMPTY);
-    return apply_move_if_valid(moves, { PLAYER_WHITE, PIECE_PAWN, field, target_field });
+const slider_attacks_s<SLIDER_INDEX> SLIDER_ATTACKS(detect_slider_index());
+
+constexpr bool field_empty(const field_state_t field) {
+    return PIECE_EMPTY == field_get_piece(field);
 }
 
-board_state_t* fill_white_pawn_candidate_moves(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    moves = add_white_pawn_move_up(moves, board, field);
-    moves = add_white_pawn_move_up_long(moves, board, field);
-    moves = add_white_pawn_capture_left_up(moves, board, field);
-    moves = add_white_pawn_capture_right_up(moves, board, field);
-    moves = add_white_pawn_capture_enpassant_left(moves, board, field);
-    moves = add_white_pawn_capture_enpassant_right(moves, board, field);
-    return moves;
+constexpr bool field_ranged_attack_along(const field_state_t field,
+    const field_direction_t direction) {
+    const piece_t piece = field_get_piece(field);
+    return PIECE_QUEEN == piece or
+        (direction_diagonal(direction) ? PIECE_BISHOP : PIECE_ROOK) == piece;
 }
 
-board_state_t* add_black_pawn_move_down(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    field_t target_field = field_down(field);
-    if (field_t::INVALID == target_field or PIECE_EMPTY != field_get_piece(board[target_field]))
-        return moves;
+bool field_occupied_by(const board_state_t& board, const field_t field, const player_t player,
+    const piece_t piece) {
+    return field_t::INVALID != field and
+        piece == field_get_piece(board[field]) and
+        player == field_get_player(board[field]);
+}
 
-    if (rank_t::_1 == field_rank(target_field)) {
-        *moves = board;
-        moves = promote_pawn_if_able(
-            moves, { PLAYER_BLACK, PIECE_PAWN, field, target_field }, PIECE_KNIGHT);
+/** Fields occupied by each player, indexed by `player_t`
+ *  With AVX2 or SSE2 enabled occupancy and player bits of 32 or 16 fields at a time are turned
+ *  into bitboard bits with a byte mask extraction. Otherwise, on little-endian targets eight
+ *  fields are loaded as one word and their occupancy and player bits are gathered with a
+ *  multiplication.
+ */
+std::array<bitboard_t, 2> player_fields(const board_state_t& board) {
+    std::array<bitboard_t, 2> result = {};
+#if defined(__AVX2__) && !defined(CHESS_SIMD_NONE)
+    const __m256i piece_mask = _mm256_set1_epi8(static_cast<char>(FIELD_PIECE_DESC.mask));
+    for (std::size_t field_idx = 0; field_idx < board.size(); field_idx += sizeof(__m256i)) {
+        const __m256i fields =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(board.data() + field_idx));
+        const __m256i empty =
+            _mm256_cmpeq_epi8(_mm256_and_si256(fields, piece_mask), _mm256_setzero_si256());
+        const uint64_t occupied = ~static_cast<uint32_t>(_mm256_movemask_epi8(empty));
+        // player bit of each field is moved to the top bit of its byte
+        const uint64_t white =
+            static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(fields, 7))) & occupied;
+        result[PLAYER_WHITE] |= white << field_idx;
+        result[PLAYER_BLACK] |= (white ^ occupied) << field_idx;
+    }
+#elif defined(__SSE2__) && !defined(CHESS_SIMD_NONE)
+    const __m128i piece_mask = _mm_set1_epi8(static_cast<char>(FIELD_PIECE_DESC.mask));
+    for (std::size_t field_idx = 0; field_idx < board.size(); field_idx += sizeof(__m128i)) {
+        const __m128i fields =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(board.data() + field_idx));
+        const __m128i empty =
+            _mm_cmpeq_epi8(_mm_and_si128(fields, piece_mask), _mm_setzero_si128());
+        const uint64_t occupied = ~static_cast<uint32_t>(_mm_movemask_epi8(empty)) & 0xFFFFu;
+        // player bit of each field is moved to the top bit of its byte
+        const uint64_t white =
+            static_cast<uint32_t>(_mm_movemask_epi8(_mm_slli_epi16(fields, 7))) & occupied;
+        result[PLAYER_WHITE] |= white << field_idx;
+        result[PLAYER_BLACK] |= (white ^ occupied) << field_idx;
+    }
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    constexpr uint64_t GATHER_BYTES = 0x0102040810204080ull;
+    for (uint8_t rank = 0; rank < 8; ++rank) {
+        uint64_t word = 0u;
+        std::memcpy(&word, board.data() + rank * 8, sizeof(word));
+        const uint64_t occupied = (((word & 0x0E0E0E0E0E0E0E0Eull) + 0x7F7F7F7F7F7F7F7Full) >> 7) &
+            0x0101010101010101ull;
+        const uint64_t white = word & occupied;
+        result[PLAYER_WHITE] |= ((white * GATHER_BYTES) >> 56) << (rank * 8);
+        result[PLAYER_BLACK] |= (((white ^ occupied) * GATHER_BYTES) >> 56) << (rank * 8);
+    }
+#else
+    for (uint8_t field_idx = 0; field_idx < 64; ++field_idx) {
+        if (not field_empty(board[field_idx]))
+            result[field_get_player(board[field_idx])] |= 1ull << field_idx;
+    }
+#endif
+    return result;
+}
 
-        *moves = board;
-        moves = promote_pawn_if_able(
-            moves, { PLAYER_BLACK, PIECE_PAWN, field, target_field }, PIECE_BISHOP);
+/** Checks whether every field holds the same piece of the same player on both boards
+ *  Player bits of empty fields, attack bits and meta bits are ignored. With AVX2 or SSE2 enabled
+ *  32 or 16 fields are compared at a time.
+ */
+bool same_pieces(const board_state_t& lhs, const board_state_t& rhs) {
+#if defined(__AVX2__) && !defined(CHESS_SIMD_NONE)
+    const __m256i piece_mask = _mm256_set1_epi8(static_cast<char>(FIELD_PIECE_DESC.mask));
+    const __m256i player_mask = _mm256_set1_epi8(static_cast<char>(FIELD_PLAYER_DESC.mask));
+    for (std::size_t field_idx = 0; field_idx < lhs.size(); field_idx += sizeof(__m256i)) {
+        const __m256i left =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs.data() + field_idx));
+        const __m256i right =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs.data() + field_idx));
+        const __m256i empty =
+            _mm256_cmpeq_epi8(_mm256_and_si256(left, piece_mask), _mm256_setzero_si256());
+        const __m256i compared =
+            _mm256_or_si256(piece_mask, _mm256_andnot_si256(empty, player_mask));
+        const __m256i diff = _mm256_and_si256(_mm256_xor_si256(left, right), compared);
+        if (not _mm256_testz_si256(diff, diff))
+            return false;
+    }
+    return true;
+#elif defined(__SSE2__) && !defined(CHESS_SIMD_NONE)
+    const __m128i piece_mask = _mm_set1_epi8(static_cast<char>(FIELD_PIECE_DESC.mask));
+    const __m128i player_mask = _mm_set1_epi8(static_cast<char>(FIELD_PLAYER_DESC.mask));
+    for (std::size_t field_idx = 0; field_idx < lhs.size(); field_idx += sizeof(__m128i)) {
+        const __m128i left =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs.data() + field_idx));
+        const __m128i right =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs.data() + field_idx));
+        const __m128i empty = _mm_cmpeq_epi8(_mm_and_si128(left, piece_mask), _mm_setzero_si128());
+        const __m128i compared = _mm_or_si128(piece_mask, _mm_andnot_si128(empty, player_mask));
+        const __m128i diff = _mm_and_si128(_mm_xor_si128(left, right), compared);
+        if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())))
+            return false;
+    }
+    return true;
+#else
+    for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
+         field_idx < static_cast<uint8_t>(field_t::END);
+         ++field_idx) {
+        auto left_field = lhs[field_idx];
+        auto right_field = rhs[field_idx];
+        if (field_get_piece(left_field) != field_get_piece(right_field) or
+            (PIECE_EMPTY != field_get_piece(left_field) and
+            field_get_player(left_field) != field_get_player(right_field))) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
 
-        *moves = board;
-        moves = promote_pawn_if_able(
-            moves, { PLAYER_BLACK, PIECE_PAWN, field, target_field }, PIECE_ROOK);
+bitboard_t occupied_fields(const board_state_t& board) {
+    const auto fields = player_fields(board);
+    return fields[PLAYER_WHITE] | fields[PLAYER_BLACK];
+}
 
-        *moves = board;
-        moves = promote_pawn_if_able(
-            moves, { PLAYER_BLACK, PIECE_PAWN, field, target_field }, PIECE_QUEEN);
-        return moves + 4;
-    } else {
-        *moves = board;
-        return apply_move_if_valid(moves, { PLAYER_BLACK, PIECE_PAWN, field, target_field });
+/** Fields attacked by a ranged `field_state` on `field`, up to the first occupied field */
+bitboard_t ranged_piece_attacks(const field_state_t field_state, const field_t field,
+    const bitboard_t occupied) {
+    switch (field_get_piece(field_state)) {
+        case PIECE_BISHOP: return bishop_attacks(field, occupied);
+        case PIECE_ROOK: return rook_attacks(field, occupied);
+        case PIECE_QUEEN: return bishop_attacks(field, occupied) | rook_attacks(field, occupied);
+        default: return 0u;
     }
 }
 
-board_state_t* add_black_pawn_move_down_long(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    if (rank_t::_7 != field_rank(field)) return moves;
-    field_t target_field = field_down(field);
-    if (field_t::INVALID == target_field or PIECE_EMPTY != field_get_piece(board[target_field]))
-        return moves;
-    target_field = field_down(target_field);
-    if (field_t::INVALID == target_field or PIECE_EMPTY != field_get_piece(board[target_field]))
-        return moves;
+/** Checks whether any of occupied `sources` holds `player`'s queen or `piece` */
+bool ranged_attacker_among(const board_state_t& board, bitboard_t sources,
+    const player_t player, const piece_t piece) {
+    for (; sources; sources &= sources - 1) {
+        const field_state_t source = board[__builtin_ctzll(sources)];
+        if (player == field_get_player(source) and
+            (piece == field_get_piece(source) or PIECE_QUEEN == field_get_piece(source)))
+            return true;
+    }
+    return false;
+}
 
-    *moves = board;
-    return apply_move_if_valid(moves, { PLAYER_BLACK, PIECE_PAWN, field, target_field });
+/** Checks whether any of `sources` holds `player`'s `piece` */
+bool piece_among(const board_state_t& board, bitboard_t sources, const player_t player,
+    const piece_t piece) {
+    for (; sources; sources &= sources - 1) {
+        const field_state_t source = board[__builtin_ctzll(sources)];
+        if (piece == field_get_piece(source) and player == field_get_player(source))
+            return true;
+    }
+    return false;
 }
 
-board_state_t* add_black_pawn_capture_left_down(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    field_t target_field = field_left_down(field);
-    if (field_t::INVALID == target_field or
-        PIECE_EMPTY == field_get_piece(board[target_field]) or
-        PLAYER_WHITE != field_get_player(board[target_field]))
-        return moves;
+/** Checks whether `player`'s king stands next to `field` */
+bool field_attacked_by_king(const board_state_t& board, const field_t field,
+    const player_t player) {
+    return piece_among(board, KING_TARGETS[field], player, PIECE_KING);
+}
 
-    *moves = board;
-    return apply_move_if_valid(moves, { PLAYER_BLACK, PIECE_PAWN, field, target_field });
+bool field_attacked_by_pawn_or_knight(const board_state_t& board, const field_t field,
+    const player_t player) {
+    return piece_among(board, PAWN_TARGETS[opponent(player)][field], player, PIECE_PAWN) or
+        piece_among(board, KNIGHT_TARGETS[field], player, PIECE_KNIGHT);
 }
 
-board_state_t* add_black_pawn_capture_right_down(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    field_t target_field = field_right_down(field);
-    if (field_t::INVALID == target_field or
-        PIECE_EMPTY == field_get_piece(board[target_field]) or
-        PLAYER_WHITE != field_get_player(board[target_field]))
-        return moves;
+/** Checks whether `player` attacks `field`, probing outward from the field
+ *  Gives the same answer as the attack bits set by `update_fields_under_attack` - in particular
+ *  ranged pieces do not attack fields occupied by their own player.
+ */
+bool field_attacked_by(const board_state_t& board, const bitboard_t occupied, const field_t field,
+    const player_t player) {
+    if (field_attacked_by_pawn_or_knight(board, field, player) or
+        field_attacked_by_king(board, field, player))
+        return true;
+    if (not field_empty(board[field]) and player == field_get_player(board[field]))
+        return false;
+    return ranged_attacker_among(
+            board, bishop_attacks(field, occupied) & occupied, player, PIECE_BISHOP) or
+        ranged_attacker_among(board, rook_attacks(field, occupied) & occupied, player, PIECE_ROOK);
+}
+
+/** Marks fields attacked by `field_state` on `field`
+ *  Attacks of ranged pieces stop at the first `occupied` field and skip `excluded` fields.
+ */
+void mark_piece_fields(uint64_t& mask, const field_state_t field_state, const field_t field,
+    const bitboard_t occupied, const bitboard_t excluded) {
+    switch (field_get_piece(field_state)) {
+        case PIECE_EMPTY: break;
+        case PIECE_PAWN: mask |= PAWN_TARGETS[field_get_player(field_state)][field]; break;
+        case PIECE_KNIGHT: mask |= KNIGHT_TARGETS[field]; break;
+        case PIECE_KING: mask |= KING_TARGETS[field]; break;
+        default:
+            mask |= ranged_piece_attacks(field_state, field, occupied) & ~excluded;
+            break;
+    }
+}
 
-    *moves = board;
-    return apply_move_if_valid(moves, { PLAYER_BLACK, PIECE_PAWN, field, target_field });
+constexpr bool field_under_attack_by(const field_state_t field, const player_t player) {
+    return PLAYER_WHITE == player
+        ? field_under_white_attack(field)
+        : field_under_black_attack(field);
 }
 
-board_state_t* add_black_pawn_capture_enpassant_left(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    if (rank_t::_4 != field_rank(field)) return moves;
+constexpr field_state_t field_set_under_attack_by(const field_state_t field,
+    const player_t player, const bool attacked) {
+    return PLAYER_WHITE == player
+        ? (attacked ? field_set_under_white_attack(field) : field_clear_under_white_attack(field))
+        : (attacked ? field_set_under_black_attack(field) : field_clear_under_black_attack(field));
+}
 
-    field_t target_field = field_left_down(field);
-    field_t opps_move_from = field_down(target_field);
-    field_t opps_move_to = field_up(target_field);
-    if (!check_last_move(board, { PLAYER_WHITE, PIECE_PAWN, opps_move_from, opps_move_to }))
-        return moves;
+/** Sets `player`'s attack on gained fields and probes fields which might have lost it
+ *
+ *  @return Fields whose attack bit of `player` was flipped.
+ */
+template <player_t P>
+uint64_t update_fields_under_attack(board_state_t& board, const bitboard_t occupied,
+    const uint64_t gained_mask, const uint64_t lost_mask) {
+    uint64_t flips = 0u;
+    for (uint64_t mask = gained_mask; mask; mask &= mask - 1) {
+        const auto field = static_cast<field_t>(__builtin_ctzll(mask));
+        if (not field_under_attack_by(board[field], P))
+            flips |= 1ull << field;
+        board[field] = field_set_under_attack_by(board[field], P, true);
+    }
+    for (uint64_t mask = lost_mask & ~gained_mask; mask; mask &= mask - 1) {
+        const auto field = static_cast<field_t>(__builtin_ctzll(mask));
+        if (field_under_attack_by(board[field], P) and
+            not field_attacked_by(board, occupied, field, P)) {
+            flips |= 1ull << field;
+            board[field] = field_set_under_attack_by(board[field], P, false);
+        }
+    }
+    return flips;
+}
 
-    *moves = board;
-    (*moves)[opps_move_to] = field_set_piece((*moves)[opps_move_to], PIECE_EMPTY);
-    return apply_move_if_valid(moves, { PLAYER_BLACK, PIECE_PAWN, field, target_field });
+/** Updates attack bits of changed `field`, probing outward from it
+ *  Ranged pieces found on the way whose ray through the field got opened or closed by the change
+ *  mark fields behind it in `gained_masks` or `lost_masks` respectively.
+ */
+void update_changed_field_under_attack(std::array<uint64_t, 2>& lost_masks,
+    std::array<uint64_t, 2>& gained_masks, board_state_t& board, const field_t field,
+    const field_state_t state_before, const bitboard_t occupied_before,
+    const std::array<bitboard_t, 2>& fields_after) {
+    const field_state_t state_after = board[field];
+    const bool discovered = field_empty(state_after) != field_empty(state_before);
+    const bitboard_t occupied_after = fields_after[PLAYER_WHITE] | fields_after[PLAYER_BLACK];
+    const bitboard_t diagonal_attacks = bishop_attacks(field, occupied_after);
+    const bitboard_t cross_attacks = rook_attacks(field, occupied_after);
+    std::array<bool, 2> attacked = {};
+    attacked[PLAYER_WHITE] = field_attacked_by_pawn_or_knight(board, field, PLAYER_WHITE);
+    attacked[PLAYER_BLACK] = field_attacked_by_pawn_or_knight(board, field, PLAYER_BLACK);
+
+    for (uint8_t direction = 0; direction < FIELD_DIRECTION_MAX; ++direction) {
+        const auto forward = static_cast<field_direction_t>(direction);
+        const bitboard_t attacks = direction_diagonal(forward) ? diagonal_attacks : cross_attacks;
+        const bitboard_t sources = attacks & FIELD_RAYS[forward][field] & occupied_after;
+        if (0u == sources) continue;
+        const auto source_field = static_cast<field_t>(__builtin_ctzll(sources));
+        if (PIECE_KING == field_get_piece(board[source_field]) and
+            FIELD_NEIGHBOURS[forward][field] == source_field) {
+            attacked[field_get_player(board[source_field])] = true;
+            continue;
+        }
+        if (not field_ranged_attack_along(board[source_field], forward))
+            continue;
+
+        const player_t player = field_get_player(board[source_field]);
+        if (field_empty(state_after) or player != field_get_player(state_after))
+            attacked[player] = true;
+        const bitboard_t behind = FIELD_RAYS[direction_opposite(forward)][field];
+        if (discovered and field_empty(state_after)) {
+            gained_masks[player] |= attacks & behind & ~fields_after[player];
+        } else if (discovered) {
+            lost_masks[player] |= behind & (direction_diagonal(forward)
+                ? bishop_attacks(field, occupied_before)
+                : rook_attacks(field, occupied_before));
+        }
+    }
+
+    board[field] = field_set_under_attack_by(board[field], PLAYER_WHITE, attacked[PLAYER_WHITE]);
+    board[field] = field_set_under_attack_by(board[field], PLAYER_BLACK, attacked[PLAYER_BLACK]);
 }
 
-board_state_t* add_black_pawn_capture_enpassant_right(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    if (rank_t::_4 != field_rank(field)) return moves;
+/** Incrementally updates fields under attack after fields listed in `undo` were changed
+ *  Attacks gained by the change are set directly. Fields which might have lost an attacker -
+ *  attacked by pieces removed from the changed fields, or behind changed fields which now block
+ *  a ranged piece - are probed again, as are the changed fields themselves. Attack bits of
+ *  `board` have to be up to date for the position before the change.
+ *
+ *  With CHESS_CHECK_ATTACK_MAP defined every update of a position which was up to date before the
+ *  change is cross-checked against a full recompute, aborting on mismatch.
+ *
+ *  @return Fields other than the changed ones whose attack bits of each player were flipped, so
+ *          that `unmake_move` restores only these instead of the whole board.
+ */
+std::array<uint64_t, 2> update_fields_under_attack(board_state_t& board, const undo_t& undo) {
+#ifdef CHESS_CHECK_ATTACK_MAP
+    board_state_t board_before = board;
+    for (uint8_t idx = 0; idx < undo.fields_cnt; ++idx)
+        board_before[undo.fields[idx]] = undo.field_states[idx];
+    const board_state_t expected_before = make_board_state_under_attack(board_before);
+    const bool up_to_date_before =
+        std::equal(board_before.begin(), board_before.end(), expected_before.begin());
+#endif
+
+    const std::array<bitboard_t, 2> fields_after = player_fields(board);
+    const bitboard_t occupied_after = fields_after[PLAYER_WHITE] | fields_after[PLAYER_BLACK];
+    bitboard_t occupied_before = occupied_after;
+    uint64_t changed_mask = 0u;
+    for (uint8_t idx = 0; idx < undo.fields_cnt; ++idx) {
+        const bitboard_t field_mask = 1ull << undo.fields[idx];
+        changed_mask |= field_mask;
+        occupied_before = field_empty(undo.field_states[idx])
+            ? occupied_before & ~field_mask
+            : occupied_before | field_mask;
+    }
 
-    field_t target_field = field_right_down(field);
-    field_t opps_move_from = field_down(target_field);
-    field_t opps_move_to = field_up(target_field);
-    if (!check_last_move(board, { PLAYER_WHITE, PIECE_PAWN, opps_move_from, opps_move_to }))
-        return moves;
+    std::array<uint64_t, 2> lost_masks = {};
+    std::array<uint64_t, 2> gained_masks = {};
+    for (uint8_t idx = 0; idx < undo.fields_cnt; ++idx) {
+        const field_t field = undo.fields[idx];
+        const field_state_t state_before = undo.field_states[idx];
+        const field_state_t state_after = board[field];
+        const player_t player = field_get_player(state_after);
+
+        mark_piece_fields(lost_masks[field_get_player(state_before)], state_before, field,
+            occupied_before, 0u);
+        mark_piece_fields(gained_masks[player], state_after, field,
+            occupied_after, fields_after[player]);
+        update_changed_field_under_attack(
+            lost_masks, gained_masks, board, field, state_before, occupied_before, fields_after);
+    }
 
-    *moves = board;
-    (*moves)[opps_move_to] = field_set_piece((*moves)[opps_move_to], PIECE_EMPTY);
-    return apply_move_if_valid(moves, { PLAYER_BLACK, PIECE_PAWN, field, target_field });
+    std::array<uint64_t, 2> attack_flips;
+    attack_flips[PLAYER_WHITE] = update_fields_under_attack<PLAYER_WHITE>(board, occupied_after,
+        gained_masks[PLAYER_WHITE] & ~changed_mask, lost_masks[PLAYER_WHITE] & ~changed_mask);
+    attack_flips[PLAYER_BLACK] = update_fields_under_attack<PLAYER_BLACK>(board, occupied_after,
+        gained_masks[PLAYER_BLACK] & ~changed_mask, lost_masks[PLAYER_BLACK] & ~changed_mask);
+
+#ifdef CHESS_CHECK_ATTACK_MAP
+    const board_state_t expected = make_board_state_under_attack(board);
+    if (up_to_date_before and not std::equal(expected.begin(), expected.end(), board.begin())) {
+        std::fprintf(stderr, "chess: incremental attack map differs from full recompute\n");
+        std::abort();
+    }
+#endif
+    return attack_flips;
 }
 
-board_state_t* fill_black_pawn_candidate_moves(
-    board_state_t* moves, const board_state_t& board, const field_t field) {
-    moves = add_black_pawn_move_down(moves, board, field);
-    moves = add_black_pawn_move_down_long(moves, board, field);
-    moves = add_black_pawn_capture_left_down(moves, board, field);
-    moves = add_black_pawn_capture_right_down(moves, board, field);
-    moves = add_black_pawn_capture_enpassant_left(moves, board, field);
-    moves = add_black_pawn_capture_enpassant_right(moves, board, field);
-    return moves;
+void update_last_move(board_state_t& board, const move_s& move) {
+    last_move_t last_move = {};
+    last_move = last_move_set_player(last_move, move.player);
+    last_move = last_move_set_piece(last_move, move.piece);
+    last_move = last_move_set_from(last_move, move.from);
+    last_move = last_move_set_to(last_move, move.to);
+    board_state_meta_set_last_move(board, last_move);
 }
 
-board_state_t* fill_pawn_candidate_moves(
-    board_state_t* moves, const board_state_t& board, const player_t player, const field_t field) {
-    return PLAYER_WHITE == player
-        ? fill_white_pawn_candidate_moves(moves, board, field)
-        : fill_black_pawn_candidate_moves(moves, board, field);
-}
-
-board_state_t* fill_regular_candidate_move(
-    board_state_t* moves, const board_state_t& board, const player_t player, const piece_t piece,
-    const field_t field, const field_t target_field) {
-    if (field_t::INVALID == target_field or
-        (PIECE_EMPTY != field_get_piece(board[target_field]) and 
-         player == field_get_player(board[target_field])) or
-        (PIECE_KING == piece and (
-            (PLAYER_WHITE == player and field_under_black_attack(board[target_field])) or
-            (PLAYER_BLACK == player and field_under_white_attack(board[target_field])))))
-        return moves;
+/** Returns castling rights after a move, with the rights of the moved king or rook and of
+ *  a captured rook removed */
+castling_rights_t castling_rights_after_move(castling_rights_t rights, const move_s& move) {
+    if (PLAYER_WHITE == move.player) {
+        if (PIECE_KING == move.piece) {
+            rights = castling_rights_remove_white_long(rights);
+            rights = castling_rights_remove_white_short(rights);
+        } else if (PIECE_ROOK == move.piece and rank_t::_1 == field_rank(move.from) and
+            (file_t::A == field_file(move.from) or file_t::H == field_file(move.from))) {
+            rights = (file_t::A == field_file(move.from)
+                ? castling_rights_remove_white_long(rights)
+                : castling_rights_remove_white_short(rights));
+        }
+    } else {
+        if (PIECE_KING == move.piece) {
+            rights = castling_rights_remove_black_long(rights);
+            rights = castling_rights_remove_black_short(rights);
+        } else if (PIECE_ROOK == move.piece and rank_t::_8 == field_rank(move.from) and
+            (file_t::A == field_file(move.from) or file_t::H == field_file(move.from))) {
+            rights = (file_t::A == field_file(move.from)
+                ? castling_rights_remove_black_long(rights)
+                : castling_rights_remove_black_short(rights));
+        }
+    }
 
-    *moves = board;
-    return apply_move_if_valid(moves, { player, piece, field, target_field });
-}
-
-board_state_t* fill_knight_candidate_moves(
-    board_state_t* moves, const board_state_t& board, const player_t player, const field_t field) {
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KNIGHT, field, field_up(field_left_up(field)));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KNIGHT, field, field_up(field_right_up(field)));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KNIGHT, field, field_left(field_left_up(field)));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KNIGHT, field, field_left(field_left_down(field)));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KNIGHT, field, field_down(field_left_down(field)));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KNIGHT, field, field_down(field_right_down(field)));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KNIGHT, field, field_right(field_right_up(field)));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KNIGHT, field, field_right(field_right_down(field)));
-    return moves;
+    switch (move.to) {
+        case A1: return castling_rights_remove_white_long(rights);
+        case H1: return castling_rights_remove_white_short(rights);
+        case A8: return castling_rights_remove_black_long(rights);
+        case H8: return castling_rights_remove_black_short(rights);
+        default: return rights;
+    }
 }
 
-board_state_t* fill_ranged_candidate_moves_op(
-    board_state_t* moves, const board_state_t& board, const player_t player, const field_t field,
-    const piece_t piece, field_t(*operation)(const field_t)) {
-    field_t target_field = field;
-    uint8_t move_cnt = 0u;
-    do {
-        target_field = operation(target_field);
-        if (field_t::INVALID == target_field) break;
-        if (PIECE_EMPTY == field_get_piece(board[target_field])) {
-            *moves = board;
-            moves = apply_move_if_valid(moves, { player, piece, field, target_field });
-            continue;
+void update_castling_rights(board_state_t& board, const move_s& move) {
+    const castling_rights_t rights = board_state_meta_get_castling_rights(board);
+    const castling_rights_t new_rights = castling_rights_after_move(rights, move);
+    if (new_rights != rights)
+        board_state_meta_set_castling_rights(board, new_rights);
+}
+
+void save_field_state(board_state_t& board, undo_t& undo, const field_t field) {
+    undo.fields[undo.fields_cnt] = field;
+    undo.field_states[undo.fields_cnt] = board[field];
+    ++undo.fields_cnt;
+}
+
+move_s describe_move(const board_state_t& board, const move_t move) {
+    const field_t from = move_get_from(move);
+    return { field_get_player(board[from]), field_get_piece(board[from]), from, move_get_to(move) };
+}
+
+void put_move_pieces(board_state_t& board, const move_t move, const move_s& details) {
+    switch (move_get_flags(move)) {
+        case MOVE_FLAG_EN_PASSANT: {
+            const field_t captured = PLAYER_WHITE == details.player
+                ? field_down(details.to)
+                : field_up(details.to);
+            board[captured] = field_set_piece(board[captured], PIECE_EMPTY);
+            break;
         }
-        if (player != field_get_player(board[target_field])) {
-            *moves = board;
-            moves = apply_move_if_valid(moves, { player, piece, field, target_field });
+        case MOVE_FLAG_CASTLING: {
+            const bool short_castle = details.to > details.from;
+            const field_t rook_from = short_castle
+                ? field_right(details.to)
+                : field_left(field_left(details.to));
+            const field_t rook_to = short_castle ? field_left(details.to) : field_right(details.to);
+            board[rook_from] = field_set_piece(board[rook_from], PIECE_EMPTY);
+            board[rook_to] = field_set_piece(
+                field_set_player(board[rook_to], details.player), PIECE_ROOK);
             break;
         }
-        break;
-    } while (true);
+    }
+
+    const piece_t piece = MOVE_FLAG_PROMOTION == move_get_flags(move)
+        ? move_get_promotion(move)
+        : details.piece;
+    board[details.from] = field_set_piece(board[details.from], PIECE_EMPTY);
+    board[details.to] = field_set_piece(field_set_player(board[details.to], details.player), piece);
+}
+
+void save_move_fields(board_state_t& board, undo_t& undo, const move_t move,
+    const move_s& details) {
+    undo.fields_cnt = 0;
+    save_field_state(board, undo, details.from);
+    save_field_state(board, undo, details.to);
+    if (MOVE_FLAG_EN_PASSANT == move_get_flags(move)) {
+        save_field_state(board, undo,
+            PLAYER_WHITE == details.player ? field_down(details.to) : field_up(details.to));
+    } else if (MOVE_FLAG_CASTLING == move_get_flags(move)) {
+        const bool short_castle = details.to > details.from;
+        save_field_state(board, undo,
+            short_castle ? field_right(details.to) : field_left(field_left(details.to)));
+        save_field_state(board, undo,
+            short_castle ? field_left(details.to) : field_right(details.to));
+    }
+}
+
+/** Flips back attack bits of fields listed in `attack_flips` of `undo` */
+void restore_fields_under_attack(board_state_t& board, const undo_t& undo) {
+    for (uint64_t mask = undo.attack_flips[PLAYER_WHITE]; mask; mask &= mask - 1)
+        board[__builtin_ctzll(mask)] ^= FIELD_UNDER_WHITE_ATTACK_DESC.mask;
+    for (uint64_t mask = undo.attack_flips[PLAYER_BLACK]; mask; mask &= mask - 1)
+        board[__builtin_ctzll(mask)] ^= FIELD_UNDER_BLACK_ATTACK_DESC.mask;
+}
+
+board_state_t* apply_candidate_move_if_valid(board_state_t* moves, const move_t move) {
+    auto& board = *moves;
+    const move_s details = describe_move(board, move);
+    undo_t undo;
+    save_move_fields(board, undo, move, details);
+    put_move_pieces(board, move, details);
+
+    update_fields_under_attack(board, undo);
+    if (not is_king_under_attack(board, details.player)) {
+        update_last_move(board, details);
+        update_castling_rights(board, details);
+        return moves + 1;
+    }
     return moves;
 }
 
-board_state_t* fill_diagonal_candidate_moves(
-    board_state_t* moves, const board_state_t& board, const player_t player, const field_t field,
-    const piece_t piece) {
-    moves = fill_ranged_candidate_moves_op(moves, board, player, field, piece, field_left_up);
-    moves = fill_ranged_candidate_moves_op(moves, board, player, field, piece, field_left_down);
-    moves = fill_ranged_candidate_moves_op(moves, board, player, field, piece, field_right_up);
-    moves = fill_ranged_candidate_moves_op(moves, board, player, field, piece, field_right_down);
+board_state_t* apply_candidate_move(board_state_t* moves, const move_t move) {
+    auto& board = *moves;
+    const move_s details = describe_move(board, move);
+    undo_t undo;
+    save_move_fields(board, undo, move, details);
+    put_move_pieces(board, move, details);
+    update_fields_under_attack(board, undo);
+    update_last_move(board, details);
+    update_castling_rights(board, details);
+    return moves + 1;
+}
+
+move_t* add_move(move_t* moves, const field_t from, const field_t to,
+    const move_flags_t flags = MOVE_FLAG_NONE) {
+    *moves = encode_move(from, to, flags);
+    return moves + 1;
+}
+
+template <player_t P>
+move_t* add_pawn_move(move_t* moves, const field_t from, const field_t to) {
+    const rank_t promotion_rank = PLAYER_WHITE == P ? rank_t::_8 : rank_t::_1;
+    if (promotion_rank != field_rank(to))
+        return add_move(moves, from, to);
+
+    for (const auto promote_to : { PIECE_KNIGHT, PIECE_BISHOP, PIECE_ROOK, PIECE_QUEEN }) {
+        *moves++ = move_set_promotion(encode_move(from, to, MOVE_FLAG_NONE), promote_to);
+    }
     return moves;
 }
 
-board_state_t* fill_cross_candidate_moves(
-    board_state_t* moves, const board_state_t& board, const player_t player, const field_t field,
-    const piece_t piece) {
-    moves = fill_ranged_candidate_moves_op(moves, board, player, field, piece, field_up);
-    moves = fill_ranged_candidate_moves_op(moves, board, player, field, piece, field_down);
-    moves = fill_ranged_candidate_moves_op(moves, board, player, field, piece, field_right);
-    moves = fill_ranged_candidate_moves_op(moves, board, player, field, piece, field_left);
+constexpr field_direction_t pawn_forward(const player_t player) {
+    return PLAYER_WHITE == player ? FIELD_DIRECTION_UP : FIELD_DIRECTION_DOWN;
+}
+
+template <player_t P>
+move_t* add_pawn_move_forward(
+    move_t* moves, const board_state_t& board, const field_t field) {
+    const field_t target_field = FIELD_NEIGHBOURS[pawn_forward(P)][field];
+    if (field_t::INVALID == target_field or PIECE_EMPTY != field_get_piece(board[target_field]))
+        return moves;
+
+    return add_pawn_move<P>(moves, field, target_field);
+}
+
+template <player_t P>
+move_t* add_pawn_move_forward_long(
+    move_t* moves, const board_state_t& board, const field_t field) {
+    if ((PLAYER_WHITE == P ? rank_t::_2 : rank_t::_7) != field_rank(field)) return moves;
+    const field_t passed_field = FIELD_NEIGHBOURS[pawn_forward(P)][field];
+    const field_t target_field = FIELD_NEIGHBOURS[pawn_forward(P)][passed_field];
+    if (PIECE_EMPTY != field_get_piece(board[passed_field]) or
+        PIECE_EMPTY != field_get_piece(board[target_field]))
+        return moves;
+
+    return add_move(moves, field, target_field);
+}
+
+template <player_t P>
+move_t* add_pawn_capture_enpassant(
+    move_t* moves, const board_state_t& board, const field_t field,
+    const field_t target_field) {
+    if ((PLAYER_WHITE == P ? rank_t::_5 : rank_t::_4) != field_rank(field)) return moves;
+
+    field_t opps_move_from = PLAYER_WHITE == P
+        ? field_up(target_field)
+        : field_down(target_field);
+    field_t opps_move_to = PLAYER_WHITE == P
+        ? field_down(target_field)
+        : field_up(target_field);
+    if (!check_last_move(board, { opponent(P), PIECE_PAWN, opps_move_from, opps_move_to }))
+        return moves;
+
+    return add_move(moves, field, target_field, MOVE_FLAG_EN_PASSANT);
+}
+
+/** Kinds of pseudo-legal moves, combined into a mask of moves to generate */
+using move_kinds_t = uint8_t;
+
+/** Captures without promotion, including en passant */
+constexpr move_kinds_t MOVE_KIND_CAPTURES = 0b001;
+/** Promotions, capturing or not */
+constexpr move_kinds_t MOVE_KIND_PROMOTIONS = 0b010;
+/** Remaining moves, including castling */
+constexpr move_kinds_t MOVE_KIND_QUIETS = 0b100;
+constexpr move_kinds_t MOVE_KIND_ALL = 0b111;
+
+template <player_t P, move_kinds_t KINDS = MOVE_KIND_ALL>
+move_t* fill_pawn_candidate_moves(move_t* moves, const board_state_t& board,
+    const field_t field, const bitboard_t enemy_fields) {
+    const bool promotion = (PLAYER_WHITE == P ? rank_t::_7 : rank_t::_2) == field_rank(field);
+    if (KINDS & (promotion ? MOVE_KIND_PROMOTIONS : MOVE_KIND_QUIETS))
+        moves = add_pawn_move_forward<P>(moves, board, field);
+    if (KINDS & MOVE_KIND_QUIETS)
+        moves = add_pawn_move_forward_long<P>(moves, board, field);
+    for (bitboard_t targets = PAWN_TARGETS[P][field]; targets; targets &= targets - 1) {
+        const auto target_field = static_cast<field_t>(__builtin_ctzll(targets));
+        if ((enemy_fields >> target_field) & 1u) {
+            if (KINDS & (promotion ? MOVE_KIND_PROMOTIONS : MOVE_KIND_CAPTURES))
+                moves = add_pawn_move<P>(moves, field, target_field);
+        } else if (KINDS & MOVE_KIND_CAPTURES) {
+            moves = add_pawn_capture_enpassant<P>(moves, board, field, target_field);
+        }
+    }
+    return moves;
+}
+
+template <player_t P, move_kinds_t KINDS>
+move_t* fill_king_step_move(move_t* moves, const board_state_t& board, const field_t field,
+    const field_t target_field) {
+    const bool capture = PIECE_EMPTY != field_get_piece(board[target_field]);
+    if ((capture and P == field_get_player(board[target_field])) or
+        0u == (KINDS & (capture ? MOVE_KIND_CAPTURES : MOVE_KIND_QUIETS)) or
+        field_under_attack_by(board[target_field], opponent(P)))
+        return moves;
+
+    return add_move(moves, field, target_field);
+}
+
+/** Fills moves of a piece on `field` to each of `target_fields` */
+move_t* fill_target_moves(move_t* moves, const field_t field, bitboard_t target_fields) {
+    for (; target_fields; target_fields &= target_fields - 1)
+        moves = add_move(moves, field, static_cast<field_t>(__builtin_ctzll(target_fields)));
     return moves;
 }
 
-board_state_t* fill_white_short_castle(
-    board_state_t* moves, const board_state_t& board, const field_t field)
+move_t* fill_white_short_castle(move_t* moves, const board_state_t& board, const field_t field)
 {
     if (E1 != field or
         PLAYER_WHITE != field_get_player(board[H1]) or
@@ -1010,14 +2176,10 @@ board_state_t* fill_white_short_castle(
         field_under_black_attack(board[G1]))
         return moves;
 
-    auto& move = *moves = board;
-    move[H1] = field_set_piece(move[H1], PIECE_EMPTY);
-    move[F1] = field_set_piece(field_set_player(move[F1], PLAYER_WHITE), PIECE_ROOK);
-    return apply_move_if_valid(moves, { PLAYER_WHITE, PIECE_KING, E1, G1 });
+    return add_move(moves, E1, G1, MOVE_FLAG_CASTLING);
 }
 
-board_state_t* fill_black_short_castle(
-    board_state_t* moves, const board_state_t& board, const field_t field)
+move_t* fill_black_short_castle(move_t* moves, const board_state_t& board, const field_t field)
 {
     if (E8 != field or
         PLAYER_BLACK != field_get_player(board[H8]) or
@@ -1030,22 +2192,19 @@ board_state_t* fill_black_short_castle(
         field_under_white_attack(board[G8]))
         return moves;
 
-    auto& move = *moves = board;
-    move[H8] = field_set_piece(move[H8], PIECE_EMPTY);
-    move[F8] = field_set_piece(field_set_player(move[F8], PLAYER_BLACK), PIECE_ROOK);
-    return apply_move_if_valid(moves, { PLAYER_BLACK, PIECE_KING, E8, G8 });
+    return add_move(moves, E8, G8, MOVE_FLAG_CASTLING);
 }
 
-board_state_t* fill_short_castle(
-    board_state_t* moves, const board_state_t& board, const player_t player, const field_t field)
+template <player_t P>
+move_t* fill_short_castle(
+    move_t* moves, const board_state_t& board, const field_t field)
 {
-    return PLAYER_WHITE == player
+    return PLAYER_WHITE == P
         ? fill_white_short_castle(moves, board, field)
         : fill_black_short_castle(moves, board, field);
 }
 
-board_state_t* fill_white_long_castle(
-    board_state_t* moves, const board_state_t& board, const field_t field)
+move_t* fill_white_long_castle(move_t* moves, const board_state_t& board, const field_t field)
 {
     if (E1 != field or
         PLAYER_WHITE != field_get_player(board[A1]) or
@@ -1059,14 +2218,10 @@ board_state_t* fill_white_long_castle(
         field_under_black_attack(board[E1]))
         return moves;
 
-    auto& move = *moves = board;
-    move[A1] = field_set_piece(move[A1], PIECE_EMPTY);
-    move[D1] = field_set_piece(field_set_player(move[D1], PLAYER_WHITE), PIECE_ROOK);
-    return apply_move_if_valid(moves, { PLAYER_WHITE, PIECE_KING, E1, C1 });
+    return add_move(moves, E1, C1, MOVE_FLAG_CASTLING);
 }
 
-board_state_t* fill_black_long_castle(
-    board_state_t* moves, const board_state_t& board, const field_t field)
+move_t* fill_black_long_castle(move_t* moves, const board_state_t& board, const field_t field)
 {
     if (E8 != field or
         PLAYER_BLACK != field_get_player(board[A8]) or
@@ -1074,46 +2229,534 @@ board_state_t* fill_black_long_castle(
         PIECE_EMPTY != field_get_piece(board[B8]) or
         PIECE_EMPTY != field_get_piece(board[C8]) or
         PIECE_EMPTY != field_get_piece(board[D8]) or
-        !castling_rights_black_long(board_state_meta_get_castling_rights(board)))
+        !castling_rights_black_long(board_state_meta_get_castling_rights(board)) or
+        field_under_white_attack(board[C8]) or
+        field_under_white_attack(board[D8]) or
+        field_under_white_attack(board[E8]))
         return moves;
 
-    auto& move = *moves = board;
-    move[A8] = field_set_piece(move[A8], PIECE_EMPTY);
-    move[D8] = field_set_piece(field_set_player(move[D8], PLAYER_BLACK), PIECE_ROOK);
-    return apply_move_if_valid(moves, { PLAYER_BLACK, PIECE_KING, E8, C8 });
+    return add_move(moves, E8, C8, MOVE_FLAG_CASTLING);
 }
 
-board_state_t* fill_long_castle(
-    board_state_t* moves, const board_state_t& board, const player_t player, const field_t field)
+template <player_t P>
+move_t* fill_long_castle(
+    move_t* moves, const board_state_t& board, const field_t field)
 {
-    return PLAYER_WHITE == player
+    return PLAYER_WHITE == P
         ? fill_white_long_castle(moves, board, field)
         : fill_black_long_castle(moves, board, field);
 }
 
-board_state_t* fill_king_candidate_moves(
-    board_state_t* moves, const board_state_t& board, const player_t player, const field_t field) {
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KING, field, field_up(field));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KING, field, field_left_up(field));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KING, field, field_right_up(field));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KING, field, field_left(field));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KING, field, field_right(field));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KING, field, field_down(field));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KING, field, field_left_down(field));
-    moves = fill_regular_candidate_move(
-        moves, board, player, PIECE_KING, field, field_right_down(field));
-    moves = fill_short_castle(moves, board, player, field);
-    moves = fill_long_castle(moves, board, player, field);
+template <player_t P, move_kinds_t KINDS = MOVE_KIND_ALL>
+move_t* fill_king_candidate_moves(
+    move_t* moves, const board_state_t& board, const field_t field) {
+    for (bitboard_t targets = KING_TARGETS[field]; targets; targets &= targets - 1) {
+        moves = fill_king_step_move<P, KINDS>(
+            moves, board, field, static_cast<field_t>(__builtin_ctzll(targets)));
+    }
+    if (KINDS & MOVE_KIND_QUIETS) {
+        moves = fill_short_castle<P>(moves, board, field);
+        moves = fill_long_castle<P>(moves, board, field);
+    }
+    return moves;
+}
+
+/** Fills moves of `KINDS` of the piece on `field` that follow piece movement rules, but may leave
+ *  own king under attack
+ *
+ *  @param fields - Occupied fields of each player, as returned by `player_fields`.
+ */
+template <player_t P, move_kinds_t KINDS = MOVE_KIND_ALL>
+move_t* fill_piece_moves(move_t* moves, const board_state_t& board, const field_t field,
+    const std::array<bitboard_t, 2>& fields) {
+    const bitboard_t occupied = fields[PLAYER_WHITE] | fields[PLAYER_BLACK];
+    const bitboard_t target_fields =
+        (KINDS & MOVE_KIND_CAPTURES ? fields[opponent(P)] : 0u) |
+        (KINDS & MOVE_KIND_QUIETS ? ~occupied : 0u);
+    switch (field_get_piece(board[field])) {
+        case PIECE_PAWN:
+            return fill_pawn_candidate_moves<P, KINDS>(moves, board, field, fields[opponent(P)]);
+        case PIECE_KNIGHT:
+            return fill_target_moves(moves, field, KNIGHT_TARGETS[field] & target_fields);
+        case PIECE_BISHOP:
+        case PIECE_ROOK:
+        case PIECE_QUEEN:
+            return fill_target_moves(moves, field,
+                ranged_piece_attacks(board[field], field, occupied) & target_fields);
+        case PIECE_KING: return fill_king_candidate_moves<P, KINDS>(moves, board, field);
+        default: return moves;
+    }
+}
+
+/** Fills moves of `KINDS` that follow piece movement rules, but may leave own king under attack */
+template <player_t P, move_kinds_t KINDS = MOVE_KIND_ALL>
+move_t* fill_pseudo_legal_moves(move_t* moves, const board_state_t& board) {
+    const std::array<bitboard_t, 2> fields = player_fields(board);
+    for (bitboard_t own_fields = fields[P]; own_fields; own_fields &= own_fields - 1) {
+        moves = fill_piece_moves<P, KINDS>(
+            moves, board, static_cast<field_t>(__builtin_ctzll(own_fields)), fields);
+    }
     return moves;
 }
 
+/** Checks whether `player` attacks `field` regardless of the field's occupant, with ranged
+ *  attacks passing through `transparent_field` */
+bool field_attacked_through(const board_state_t& board, const bitboard_t occupied,
+    const field_t field, const player_t player, const field_t transparent_field) {
+    if (field_attacked_by_pawn_or_knight(board, field, player) or
+        field_attacked_by_king(board, field, player))
+        return true;
+
+    const bitboard_t sources = occupied & ~(1ull << transparent_field);
+    return ranged_attacker_among(
+            board, bishop_attacks(field, sources) & sources, player, PIECE_BISHOP) or
+        ranged_attacker_among(board, rook_attacks(field, sources) & sources, player, PIECE_ROOK);
+}
+
+template <player_t P>
+detail::legal_info_s make_legal_info(const board_state_t& board, const field_t king) {
+    detail::legal_info_s info = {};
+    info.king = king;
+    if (field_t::INVALID == info.king)
+        return info;
+
+    const player_t enemy = opponent(P);
+    auto add_checker = [&](const field_t field, const uint64_t ray_mask) {
+        ++info.checkers_cnt;
+        info.evasion_mask |= ray_mask | (1ull << field);
+    };
+
+    auto add_leaper_checkers = [&](bitboard_t sources, const piece_t piece) {
+        for (; sources; sources &= sources - 1) {
+            const auto field = static_cast<field_t>(__builtin_ctzll(sources));
+            if (field_occupied_by(board, field, enemy, piece))
+                add_checker(field, 0u);
+        }
+    };
+    add_leaper_checkers(PAWN_TARGETS[P][info.king], PIECE_PAWN);
+    add_leaper_checkers(KNIGHT_TARGETS[info.king], PIECE_KNIGHT);
+
+    info.occupied = occupied_fields(board);
+    const bitboard_t diagonal_attacks = bishop_attacks(info.king, info.occupied);
+    const bitboard_t cross_attacks = rook_attacks(info.king, info.occupied);
+    for (uint8_t direction = 0; direction < FIELD_DIRECTION_MAX; ++direction) {
+        const auto ray_direction = static_cast<field_direction_t>(direction);
+        const bool diagonal = direction_diagonal(ray_direction);
+        const bitboard_t ray = FIELD_RAYS[direction][info.king];
+        const bitboard_t ray_mask = (diagonal ? diagonal_attacks : cross_attacks) & ray;
+        const bitboard_t blocker = ray_mask & info.occupied;
+        if (0u == blocker) continue;
+        const auto field = static_cast<field_t>(__builtin_ctzll(blocker));
+        if (enemy == field_get_player(board[field])) {
+            if (field_ranged_attack_along(board[field], ray_direction))
+                add_checker(field, ray_mask);
+            continue;
+        }
+
+        const bitboard_t occupied_behind = info.occupied & ~blocker;
+        const bitboard_t pin_ray = ray & (diagonal
+            ? bishop_attacks(info.king, occupied_behind)
+            : rook_attacks(info.king, occupied_behind));
+        const bitboard_t pinner = pin_ray & occupied_behind;
+        if (0u == pinner) continue;
+        const auto pinner_field = static_cast<field_t>(__builtin_ctzll(pinner));
+        if (enemy == field_get_player(board[pinner_field]) and
+            field_ranged_attack_along(board[pinner_field], ray_direction)) {
+            info.pinned_mask |= blocker;
+            info.pin_rays[direction] = pin_ray;
+        }
+    }
+    return info;
+}
+
+template <player_t P>
+detail::legal_info_s make_legal_info(const board_state_t& board) {
+    for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
+         field_idx < static_cast<uint8_t>(field_t::END);
+         ++field_idx) {
+        if (PIECE_KING == field_get_piece(board[field_idx]) and
+            P == field_get_player(board[field_idx]))
+            return make_legal_info<P>(board, static_cast<field_t>(field_idx));
+    }
+    return make_legal_info<P>(board, field_t::INVALID);
+}
+
+/** Checks legality of a pseudo-legal move using checkers and pins of the moving player's king */
+template <player_t P>
+bool move_legal(
+    const board_state_t& board, const detail::legal_info_s& info, const move_t move) {
+    const field_t from = move_get_from(move);
+    const field_t to = move_get_to(move);
+    if (from == info.king) {
+        if (MOVE_FLAG_CASTLING == move_get_flags(move))
+            return true;
+        return not field_under_attack_by(board[to], opponent(P)) and
+            not field_attacked_through(board, info.occupied, to, opponent(P), info.king);
+    }
+    if (MOVE_FLAG_EN_PASSANT == move_get_flags(move)) {
+        board_state_t move_board = board;
+        return &move_board != apply_candidate_move_if_valid(&move_board, move);
+    }
+    if (info.checkers_cnt > 1 or
+        (1 == info.checkers_cnt and 0u == ((info.evasion_mask >> to) & 1u)))
+        return false;
+    if (0u != ((info.pinned_mask >> from) & 1u)) {
+        for (const auto pin_ray : info.pin_rays) {
+            if ((pin_ray >> from) & 1u)
+                return 0u != ((pin_ray >> to) & 1u);
+        }
+    }
+    return true;
+}
+
+void piece_list_add(piece_list_t& pieces, const field_t field, const field_state_t state) {
+    const player_t player = field_get_player(state);
+    pieces.indices[field] = pieces.counts[player];
+    pieces.fields[player][pieces.counts[player]++] = field;
+    if (PIECE_KING == field_get_piece(state))
+        pieces.kings[player] = field;
+}
+
+void piece_list_remove(piece_list_t& pieces, const field_t field, const field_state_t state) {
+    const player_t player = field_get_player(state);
+    const field_t last_field = pieces.fields[player][--pieces.counts[player]];
+    pieces.fields[player][pieces.indices[field]] = last_field;
+    pieces.indices[last_field] = pieces.indices[field];
+    if (PIECE_KING == field_get_piece(state) and field == pieces.kings[player])
+        pieces.kings[player] = field_t::INVALID;
+}
+
+/** Updates piece lists after `fields` changed from `states_before` to their states on `board` */
+void update_piece_list(piece_list_t& pieces, const board_state_t& board,
+    const std::array<field_t, 4>& fields, const std::array<field_state_t, 4>& states_before,
+    const uint8_t fields_cnt) {
+    for (uint8_t idx = 0; idx < fields_cnt; ++idx) {
+        if (PIECE_EMPTY != field_get_piece(states_before[idx]))
+            piece_list_remove(pieces, fields[idx], states_before[idx]);
+    }
+    for (uint8_t idx = 0; idx < fields_cnt; ++idx) {
+        if (PIECE_EMPTY != field_get_piece(board[fields[idx]]))
+            piece_list_add(pieces, fields[idx], board[fields[idx]]);
+    }
+}
+
+/** Removes moves which are not legal from `moves`, keeping the order of the remaining ones */
+template <player_t P>
+move_t* keep_legal_moves(move_t* moves, const move_t* moves_end, const board_state_t& board,
+    const detail::legal_info_s& info) {
+    move_t* legal_moves_end = moves;
+    for (auto it = moves; it != moves_end; ++it) {
+        if (move_legal<P>(board, info, *it))
+            *legal_moves_end++ = *it;
+    }
+    return legal_moves_end;
+}
+
+/** Fills legal moves of `KINDS` out of check
+ *  King steps to fields which are not attacked, and in single check captures of the checker and
+ *  interpositions on the checking ray. Pinned pieces can never resolve a check, so they are not
+ *  considered, and knight and ranged moves are restricted to the evasion fields, so they need no
+ *  further verification. Moves are generated in the same order as pseudo-legal moves.
+ */
+template <player_t P, move_kinds_t KINDS = MOVE_KIND_ALL>
+move_t* fill_evasion_moves(
+    move_t* moves, const board_state_t& board, const detail::legal_info_s& info) {
+    const std::array<bitboard_t, 2> fields = player_fields(board);
+    const bitboard_t king_field = 1ull << info.king;
+    const bitboard_t evasion_fields = info.evasion_mask &
+        ((KINDS & MOVE_KIND_CAPTURES ? fields[opponent(P)] : 0u) |
+         (KINDS & MOVE_KIND_QUIETS ? ~info.occupied : 0u));
+    const bitboard_t movers = info.checkers_cnt > 1
+        ? king_field
+        : fields[P] & ~info.pinned_mask;
+    for (bitboard_t own_fields = movers; own_fields; own_fields &= own_fields - 1) {
+        const auto field = static_cast<field_t>(__builtin_ctzll(own_fields));
+        switch (field_get_piece(board[field])) {
+            case PIECE_PAWN:
+                moves = keep_legal_moves<P>(moves,
+                    fill_pawn_candidate_moves<P, KINDS>(moves, board, field, fields[opponent(P)]),
+                    board, info);
+                break;
+            case PIECE_KNIGHT:
+                moves = fill_target_moves(moves, field, KNIGHT_TARGETS[field] & evasion_fields);
+                break;
+            case PIECE_BISHOP:
+            case PIECE_ROOK:
+            case PIECE_QUEEN:
+                moves = fill_target_moves(moves, field,
+                    ranged_piece_attacks(board[field], field, info.occupied) & evasion_fields);
+                break;
+            case PIECE_KING: {
+                move_t* king_moves_end = moves;
+                for (bitboard_t targets = KING_TARGETS[field]; targets; targets &= targets - 1) {
+                    king_moves_end = fill_king_step_move<P, KINDS>(king_moves_end, board, field,
+                        static_cast<field_t>(__builtin_ctzll(targets)));
+                }
+                moves = keep_legal_moves<P>(moves, king_moves_end, board, info);
+                break;
+            }
+            default: break;
+        }
+    }
+    return moves;
+}
+
+/** Fills legal moves of `KINDS`, with the dedicated evasion generator in check */
+template <player_t P, move_kinds_t KINDS = MOVE_KIND_ALL>
+move_t* fill_legal_moves(
+    move_t* moves, const board_state_t& board, const detail::legal_info_s& info) {
+    if (info.checkers_cnt > 0)
+        return fill_evasion_moves<P, KINDS>(moves, board, info);
+
+    return keep_legal_moves<P>(
+        moves, fill_pseudo_legal_moves<P, KINDS>(moves, board), board, info);
+}
+
+/** Fills positions after legal moves of `KINDS` */
+template <player_t P, move_kinds_t KINDS = MOVE_KIND_ALL>
+board_state_t* fill_legal_positions(board_state_t* moves, const board_state_t& board) {
+    move_t move_list[256];
+    const move_t* move_list_end =
+        fill_legal_moves<P, KINDS>(move_list, board, make_legal_info<P>(board));
+    for (auto it = move_list; it != move_list_end; ++it) {
+        *moves = board;
+        moves = apply_candidate_move(moves, *it);
+    }
+    return moves;
+}
+
+/** Random keys xor-ed into `position_key_t` */
+struct zobrist_keys_s {
+    /** Keys of pieces on fields, indexed with `player_t`, `piece_t` and `field_t`. Keys of
+     *  `PIECE_EMPTY` are 0, so empty fields do not change the key whatever their player bit. */
+    std::array<std::array<std::array<position_key_t, 64>, 8>, 2> pieces;
+    /** Keys of castling rights, indexed with `castling_rights_t` */
+    std::array<position_key_t, 16> castling_rights;
+    /** Keys of files of pawns which can be captured en passant */
+    std::array<position_key_t, 8> en_passant_files;
+    /** Key of positions with black to move */
+    position_key_t black_to_move;
+};
+
+/** SplitMix64 generator of the random keys, advances `state` */
+constexpr uint64_t next_zobrist_key(uint64_t& state) {
+    state += 0x9e3779b97f4a7c15ull;
+    uint64_t key = state;
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+    return key ^ (key >> 31);
+}
+
+constexpr zobrist_keys_s make_zobrist_keys() {
+    zobrist_keys_s keys = {};
+    uint64_t state = 0;
+    for (auto& player_keys : keys.pieces) {
+        for (piece_t piece = PIECE_PAWN; piece <= PIECE_KING; ++piece) {
+            for (auto& key : player_keys[piece])
+                key = next_zobrist_key(state);
+        }
+    }
+    for (auto& key : keys.castling_rights)
+        key = next_zobrist_key(state);
+    for (auto& key : keys.en_passant_files)
+        key = next_zobrist_key(state);
+    keys.black_to_move = next_zobrist_key(state);
+    return keys;
+}
+
+constexpr zobrist_keys_s ZOBRIST_KEYS = make_zobrist_keys();
+
+constexpr position_key_t piece_key(const field_state_t field_state, const field_t field) {
+    return ZOBRIST_KEYS.pieces[field_get_player(field_state)][field_get_piece(field_state)][field];
+}
+
+/** Returns key of the file of a pawn which moved two fields, if it can be captured en passant
+ *  by a pawn of `player` - one of them stands next to it - and 0 otherwise */
+position_key_t en_passant_key(const board_state_t& board, const move_s& move,
+    const player_t player) {
+    if (PIECE_PAWN != move.piece or
+        16 != (move.to > move.from ? move.to - move.from : move.from - move.to))
+        return 0u;
+    const bool capturable =
+        (file_t::A != field_file(move.to) and
+         field_occupied_by(board, field_left(move.to), player, PIECE_PAWN)) or
+        (file_t::H != field_file(move.to) and
+         field_occupied_by(board, field_right(move.to), player, PIECE_PAWN));
+    return capturable
+        ? ZOBRIST_KEYS.en_passant_files[static_cast<uint8_t>(field_file(move.to))]
+        : 0u;
+}
+
+/** Returns key of the pawn which moved two fields in the last move of the position, if it can be
+ *  captured en passant, and 0 otherwise */
+position_key_t en_passant_key(const board_state_t& board) {
+    const last_move_t last_move = board_state_meta_get_last_move(board);
+    const move_s move = {
+        last_move_get_player(last_move), last_move_get_piece(last_move),
+        last_move_get_from(last_move), last_move_get_to(last_move)
+    };
+    return en_passant_key(board, move, opponent(move.player));
+}
+
+/** Returns offset of the count of `player`'s `piece` in `material_key_t`, kings are not counted */
+constexpr uint8_t material_key_shift(const player_t player, const piece_t piece) {
+    return player * 20 + (piece - PIECE_PAWN) * 4;
+}
+
+/** Returns `material_key_t` of a single piece, 0 for empty fields and kings */
+constexpr material_key_t material_key_piece(const field_state_t field_state) {
+    const piece_t piece = field_get_piece(field_state);
+    return PIECE_EMPTY == piece or PIECE_KING == piece
+        ? 0u
+        : 1ull << material_key_shift(field_get_player(field_state), piece);
+}
+
+/** Returns field of the pawn captured en passant by `move` */
+field_t en_passant_captured_field(const move_s& move) {
+    return PLAYER_WHITE == move.player ? field_down(move.to) : field_up(move.to);
+}
+
+/** Returns field of `player`'s king, `field_t::INVALID` if there is none */
+field_t find_king(const board_state_t& board, const player_t player) {
+    for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
+         field_idx < static_cast<uint8_t>(field_t::END);
+         ++field_idx) {
+        if (PIECE_KING == field_get_piece(board[field_idx]) and
+            player == field_get_player(board[field_idx]))
+            return static_cast<field_t>(field_idx);
+    }
+    return field_t::INVALID;
+}
+
+/** Checks whether `piece` of `player` standing on `field` attacks `target` */
+bool piece_attacks(const piece_t piece, const player_t player, const field_t field,
+    const field_t target, const bitboard_t occupied) {
+    bitboard_t targets = 0u;
+    switch (piece) {
+        case PIECE_PAWN: targets = PAWN_TARGETS[player][field]; break;
+        case PIECE_KNIGHT: targets = KNIGHT_TARGETS[field]; break;
+        case PIECE_BISHOP: targets = bishop_attacks(field, occupied); break;
+        case PIECE_ROOK: targets = rook_attacks(field, occupied); break;
+        case PIECE_QUEEN:
+            targets = bishop_attacks(field, occupied) | rook_attacks(field, occupied);
+            break;
+        default: break;
+    }
+    return (targets >> target) & 1u;
+}
+
+/** Piece values used by static exchange evaluation, indexed with `piece_t` */
+constexpr std::array<int, PIECE_KING + 1> SEE_PIECE_VALUES = {
+    0, 100, 300, 300, 500, 900, 20000
+};
+
+/** Finds `player`'s least valuable piece attacking `field` with pieces on `occupied` fields only
+ *
+ *  @return Field of the attacker, `field_t::INVALID` if there is none.
+ */
+field_t least_valuable_attacker(const board_state_t& board, const field_t field,
+    const bitboard_t occupied, const player_t player) {
+    const bitboard_t diagonal_sources = bishop_attacks(field, occupied) & occupied;
+    const bitboard_t cross_sources = rook_attacks(field, occupied) & occupied;
+    const std::array<bitboard_t, PIECE_KING + 1> piece_sources = {
+        0u,
+        PAWN_TARGETS[opponent(player)][field] & occupied,
+        KNIGHT_TARGETS[field] & occupied,
+        diagonal_sources,
+        cross_sources,
+        diagonal_sources | cross_sources,
+        KING_TARGETS[field] & occupied
+    };
+    for (piece_t piece = PIECE_PAWN; piece <= PIECE_KING; ++piece) {
+        for (bitboard_t sources = piece_sources[piece]; sources; sources &= sources - 1) {
+            const auto source = static_cast<field_t>(__builtin_ctzll(sources));
+            if (piece == field_get_piece(board[source]) and
+                player == field_get_player(board[source]))
+                return source;
+        }
+    }
+    return field_t::INVALID;
+}
+
+/** Returns fields from the king up to the piece pinning the piece on `field` */
+bitboard_t pin_ray(const detail::legal_info_s& info, const field_t field) {
+    for (const auto ray : info.pin_rays) {
+        if ((ray >> field) & 1u)
+            return ray;
+    }
+    return 0u;
+}
+
+template <player_t P>
+piece_move_counts_t count_legal_moves_by_piece(const board_state_t& board) {
+    const detail::legal_info_s info = make_legal_info<P>(board);
+    const std::array<bitboard_t, 2> fields = player_fields(board);
+    const bitboard_t occupied = fields[PLAYER_WHITE] | fields[PLAYER_BLACK];
+    const bitboard_t target_mask =
+        ~fields[P] & (info.checkers_cnt > 0 ? info.evasion_mask : ~0ull);
+    const bitboard_t movers = info.checkers_cnt > 1 ? 1ull << info.king : fields[P];
+
+    piece_move_counts_t counts = {};
+    for (bitboard_t own_fields = movers; own_fields; own_fields &= own_fields - 1) {
+        const auto field = static_cast<field_t>(__builtin_ctzll(own_fields));
+        const piece_t piece = field_get_piece(board[field]);
+        const bitboard_t pin_mask =
+            (info.pinned_mask >> field) & 1u ? pin_ray(info, field) : ~0ull;
+        switch (piece) {
+            case PIECE_KNIGHT:
+                counts[piece] +=
+                    __builtin_popcountll(KNIGHT_TARGETS[field] & target_mask & pin_mask);
+                break;
+            case PIECE_BISHOP:
+            case PIECE_ROOK:
+            case PIECE_QUEEN:
+                counts[piece] += __builtin_popcountll(
+                    ranged_piece_attacks(board[field], field, occupied) & target_mask & pin_mask);
+                break;
+            case PIECE_PAWN:
+            case PIECE_KING: {
+                move_t moves[16];
+                counts[piece] += keep_legal_moves<P>(
+                    moves, fill_piece_moves<P>(moves, board, field, fields), board, info) - moves;
+                break;
+            }
+            default: break;
+        }
+    }
+    return counts;
+}
+
+/** Generates legal moves of the next pieces of the iterator until one of them has any */
+template <player_t P>
+void fill_next_piece_moves(legal_move_iterator_t& it) {
+    while (it.moves_idx == it.moves_cnt and it.pending_fields) {
+        const auto field = static_cast<field_t>(__builtin_ctzll(it.pending_fields));
+        it.pending_fields &= it.pending_fields - 1;
+        move_t* moves = it.moves.data();
+        const move_t* moves_end = keep_legal_moves<P>(moves,
+            fill_piece_moves<P>(moves, *it.board, field, it.fields), *it.board, it.legal_info);
+        it.moves_idx = 0;
+        it.moves_cnt = static_cast<uint8_t>(moves_end - moves);
+    }
+}
+
+template <player_t P>
+legal_move_iterator_t make_legal_move_iterator(const board_state_t& board) {
+    legal_move_iterator_t it;
+    it.board = &board;
+    it.player = P;
+    it.fields = player_fields(board);
+    it.legal_info = make_legal_info<P>(board);
+    // in double check only the king can move
+    it.pending_fields = it.legal_info.checkers_cnt > 1
+        ? 1ull << it.legal_info.king
+        : it.fields[P];
+    it.moves_idx = 0;
+    it.moves_cnt = 0;
+    fill_next_piece_moves<P>(it);
+    return it;
+}
+
 }  // namespace
 
 /*  @} */ // private-impl
@@ -1205,6 +2848,46 @@ constexpr field_t last_move_get_to(last_move_t last_move) {
     return static_cast<field_t>(bitfield::get_property(last_move, LAST_MOVE_TO_DESC));
 }
 
+constexpr move_t move_set_from(move_t move, field_t from) {
+    return bitfield::set_property(move, from, MOVE_FROM_DESC);
+}
+
+constexpr field_t move_get_from(move_t move) {
+    return static_cast<field_t>(bitfield::get_property(move, MOVE_FROM_DESC));
+}
+
+constexpr move_t move_set_to(move_t move, field_t to) {
+    return bitfield::set_property(move, to, MOVE_TO_DESC);
+}
+
+constexpr field_t move_get_to(move_t move) {
+    return static_cast<field_t>(bitfield::get_property(move, MOVE_TO_DESC));
+}
+
+constexpr move_t move_set_flags(move_t move, move_flags_t flags) {
+    return bitfield::set_property(move, flags, MOVE_FLAGS_DESC);
+}
+
+constexpr move_flags_t move_get_flags(move_t move) {
+    return static_cast<move_flags_t>(bitfield::get_property(move, MOVE_FLAGS_DESC));
+}
+
+constexpr move_t move_set_promotion(move_t move, piece_t piece) {
+    return move_set_flags(
+        bitfield::set_property(move, piece - PIECE_KNIGHT, MOVE_PROMOTION_DESC),
+        MOVE_FLAG_PROMOTION);
+}
+
+constexpr piece_t move_get_promotion(move_t move) {
+    return MOVE_FLAG_PROMOTION == move_get_flags(move)
+        ? static_cast<piece_t>(PIECE_KNIGHT + bitfield::get_property(move, MOVE_PROMOTION_DESC))
+        : PIECE_EMPTY;
+}
+
+constexpr move_t encode_move(const field_t from, const field_t to, const move_flags_t flags) {
+    return move_set_flags(move_set_to(move_set_from(move_t{}, from), to), flags);
+}
+
 constexpr castling_rights_t castling_rights_remove_white_short(const castling_rights_t rights) {
     return rights | CASTLING_RIGHTS_WHITE_SHORT;
 }
@@ -1315,42 +2998,446 @@ constexpr field_t field_right_down(const field_t field) {
         static_cast<uint8_t>(field_file(field)) + 1, static_cast<uint8_t>(field_rank(field)) - 1);
 }
 
-board_state_t* fill_candidate_moves(
-    board_state_t* moves, const board_state_t& board, const player_t player) {
-    auto temp_moves = moves;
+constexpr void update_fields_under_attack(board_state_t& board) {
+    clear_fields_under_attack(board);
     for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
          field_idx < static_cast<uint8_t>(field_t::END);
          ++field_idx) {
-        if (player != field_get_player(board[field_idx])) continue;
-
         field_t field = static_cast<field_t>(field_idx);
-        piece_t piece = field_get_piece(board[field_idx]);
-        if (PIECE_PAWN == piece) {
-            moves = fill_pawn_candidate_moves(moves, board, player, field);
-            continue;
-        }
-        if (PIECE_KNIGHT == piece) {
-            moves = fill_knight_candidate_moves(moves, board, player, field);
-            continue;
+        piece_t piece = field_get_piece(board[field]);
+        if (PLAYER_WHITE == field_get_player(board[field])) {
+            update_piece_fields_under_attack<PLAYER_WHITE>(board, field, piece);
+        } else {
+            update_piece_fields_under_attack<PLAYER_BLACK>(board, field, piece);
         }
-        if (PIECE_BISHOP == piece) {
-            moves = fill_diagonal_candidate_moves(moves, board, player, field, piece);
-            continue;
+    }
+}
+
+template <player_t P>
+board_state_t* fill_candidate_moves(board_state_t* moves, const board_state_t& board,
+    const generation_mode_t mode) {
+    if (generation_mode_t::PIN_AND_CHECK_AWARE == mode)
+        return fill_legal_positions<P>(moves, board);
+
+    move_t move_list[256];
+    const move_t* move_list_end = fill_pseudo_legal_moves<P>(move_list, board);
+    for (auto it = move_list; it != move_list_end; ++it) {
+        *moves = board;
+        moves = apply_candidate_move_if_valid(moves, *it);
+    }
+    return moves;
+}
+
+template <player_t P>
+move_t* fill_move_list(move_t* moves, const board_state_t& board, const generation_mode_t mode) {
+    if (generation_mode_t::PIN_AND_CHECK_AWARE == mode)
+        return fill_legal_moves<P>(moves, board, make_legal_info<P>(board));
+
+    const move_t* moves_end = fill_pseudo_legal_moves<P>(moves, board);
+    board_state_t hot_board = board;
+    undo_t undo;
+    move_t* legal_moves_end = moves;
+    for (auto it = moves; it != moves_end; ++it) {
+        make_move(hot_board, *it, undo);
+        if (not is_king_under_attack(hot_board, P))
+            *legal_moves_end++ = *it;
+        unmake_move(hot_board, undo);
+    }
+    return legal_moves_end;
+}
+
+board_state_t* fill_candidate_moves(board_state_t* moves, const board_state_t& board,
+    const player_t player, const generation_mode_t mode) {
+    return PLAYER_WHITE == player
+        ? fill_candidate_moves<PLAYER_WHITE>(moves, board, mode)
+        : fill_candidate_moves<PLAYER_BLACK>(moves, board, mode);
+}
+
+move_t* fill_move_list(move_t* moves, const board_state_t& board, const player_t player,
+    const generation_mode_t mode) {
+    return PLAYER_WHITE == player
+        ? fill_move_list<PLAYER_WHITE>(moves, board, mode)
+        : fill_move_list<PLAYER_BLACK>(moves, board, mode);
+}
+
+template <player_t P>
+board_state_t* fill_capture_moves(board_state_t* moves, const board_state_t& board) {
+    return fill_legal_positions<P, MOVE_KIND_CAPTURES | MOVE_KIND_PROMOTIONS>(moves, board);
+}
+
+template <player_t P>
+move_t* fill_capture_moves(move_t* moves, const board_state_t& board) {
+    return fill_legal_moves<P, MOVE_KIND_CAPTURES | MOVE_KIND_PROMOTIONS>(
+        moves, board, make_legal_info<P>(board));
+}
+
+template <player_t P>
+board_state_t* fill_quiet_moves(board_state_t* moves, const board_state_t& board) {
+    return fill_legal_positions<P, MOVE_KIND_QUIETS>(moves, board);
+}
+
+template <player_t P>
+move_t* fill_quiet_moves(move_t* moves, const board_state_t& board) {
+    return fill_legal_moves<P, MOVE_KIND_QUIETS>(moves, board, make_legal_info<P>(board));
+}
+
+board_state_t* fill_capture_moves(board_state_t* moves, const board_state_t& board,
+    const player_t player) {
+    return PLAYER_WHITE == player
+        ? fill_capture_moves<PLAYER_WHITE>(moves, board)
+        : fill_capture_moves<PLAYER_BLACK>(moves, board);
+}
+
+move_t* fill_capture_moves(move_t* moves, const board_state_t& board, const player_t player) {
+    return PLAYER_WHITE == player
+        ? fill_capture_moves<PLAYER_WHITE>(moves, board)
+        : fill_capture_moves<PLAYER_BLACK>(moves, board);
+}
+
+board_state_t* fill_quiet_moves(board_state_t* moves, const board_state_t& board,
+    const player_t player) {
+    return PLAYER_WHITE == player
+        ? fill_quiet_moves<PLAYER_WHITE>(moves, board)
+        : fill_quiet_moves<PLAYER_BLACK>(moves, board);
+}
+
+move_t* fill_quiet_moves(move_t* moves, const board_state_t& board, const player_t player) {
+    return PLAYER_WHITE == player
+        ? fill_quiet_moves<PLAYER_WHITE>(moves, board)
+        : fill_quiet_moves<PLAYER_BLACK>(moves, board);
+}
+
+move_t legal_move_iterator_t::operator*() const {
+    return moves[moves_idx];
+}
+
+legal_move_iterator_t& legal_move_iterator_t::operator++() {
+    ++moves_idx;
+    if (PLAYER_WHITE == player)
+        fill_next_piece_moves<PLAYER_WHITE>(*this);
+    else
+        fill_next_piece_moves<PLAYER_BLACK>(*this);
+    return *this;
+}
+
+bool legal_move_iterator_t::operator!=(legal_moves_end_t) const {
+    return moves_idx != moves_cnt;
+}
+
+legal_move_iterator_t legal_moves_t::begin() const {
+    return PLAYER_WHITE == player
+        ? make_legal_move_iterator<PLAYER_WHITE>(*board)
+        : make_legal_move_iterator<PLAYER_BLACK>(*board);
+}
+
+legal_moves_end_t legal_moves_t::end() const {
+    return {};
+}
+
+legal_moves_t legal_moves(const board_state_t& board, const player_t player) {
+    return { &board, player };
+}
+
+bool has_legal_move(const board_state_t& board, const player_t player) {
+    return legal_moves(board, player).begin() != legal_moves_end_t{};
+}
+
+std::size_t count_legal_moves(const board_state_t& board, const player_t player) {
+    const piece_move_counts_t counts = count_legal_moves_by_piece(board, player);
+    return std::accumulate(counts.begin(), counts.end(), std::size_t{0});
+}
+
+piece_move_counts_t count_legal_moves_by_piece(const board_state_t& board, const player_t player) {
+    return PLAYER_WHITE == player
+        ? count_legal_moves_by_piece<PLAYER_WHITE>(board)
+        : count_legal_moves_by_piece<PLAYER_BLACK>(board);
+}
+
+bool gives_check(const board_state_t& board, const move_t move) {
+    const field_t from = move_get_from(move);
+    const field_t to = move_get_to(move);
+    const player_t player = field_get_player(board[from]);
+    const field_t king = find_king(board, opponent(player));
+    if (field_t::INVALID == king)
+        return false;
+
+    bitboard_t occupied = (occupied_fields(board) & ~(1ull << from)) | (1ull << to);
+    piece_t piece = field_get_piece(board[from]);
+    switch (move_get_flags(move)) {
+        case MOVE_FLAG_EN_PASSANT:
+            occupied &= ~(1ull << (PLAYER_WHITE == player ? field_down(to) : field_up(to)));
+            break;
+        case MOVE_FLAG_PROMOTION:
+            piece = move_get_promotion(move);
+            break;
+        case MOVE_FLAG_CASTLING: {
+            const bool short_castle = to > from;
+            const field_t rook_from = short_castle ? field_right(to) : field_left(field_left(to));
+            const field_t rook_to = short_castle ? field_left(to) : field_right(to);
+            occupied = (occupied & ~(1ull << rook_from)) | (1ull << rook_to);
+            if (piece_attacks(PIECE_ROOK, player, rook_to, king, occupied))
+                return true;
+            break;
         }
-        if (PIECE_ROOK == piece) {
-            moves = fill_cross_candidate_moves(moves, board, player, field, piece);
-            continue;
+    }
+    if (piece_attacks(piece, player, to, king, occupied))
+        return true;
+
+    // discovered check - the moved piece does not stand on its source field any more and the
+    // piece captured on `to` is not a ranged attacker of `player`
+    const bitboard_t sources = occupied & ~(1ull << to);
+    return ranged_attacker_among(
+            board, bishop_attacks(king, occupied) & sources, player, PIECE_BISHOP) or
+        ranged_attacker_among(board, rook_attacks(king, occupied) & sources, player, PIECE_ROOK);
+}
+
+int see(const board_state_t& board, const move_t move) {
+    if (MOVE_FLAG_CASTLING == move_get_flags(move))
+        return 0;
+
+    const field_t from = move_get_from(move);
+    const field_t to = move_get_to(move);
+    player_t player = field_get_player(board[from]);
+    bitboard_t occupied = occupied_fields(board) & ~(1ull << from);
+
+    // gains[depth] - material won by the player capturing at `depth`, if the sequence ends there
+    std::array<int, 32> gains;
+    int depth = 0;
+    piece_t piece_on_field = field_get_piece(board[from]);
+    switch (move_get_flags(move)) {
+        case MOVE_FLAG_EN_PASSANT:
+            gains[0] = SEE_PIECE_VALUES[PIECE_PAWN];
+            occupied &= ~(1ull << (PLAYER_WHITE == player ? field_down(to) : field_up(to)));
+            break;
+        case MOVE_FLAG_PROMOTION:
+            piece_on_field = move_get_promotion(move);
+            gains[0] = SEE_PIECE_VALUES[field_get_piece(board[to])] +
+                SEE_PIECE_VALUES[piece_on_field] - SEE_PIECE_VALUES[PIECE_PAWN];
+            break;
+        default:
+            gains[0] = SEE_PIECE_VALUES[field_get_piece(board[to])];
+            break;
+    }
+
+    while (depth + 1 < static_cast<int>(gains.size())) {
+        player = opponent(player);
+        const field_t attacker = least_valuable_attacker(board, to, occupied, player);
+        if (field_t::INVALID == attacker)
+            break;
+        ++depth;
+        gains[depth] = SEE_PIECE_VALUES[piece_on_field] - gains[depth - 1];
+        occupied &= ~(1ull << attacker);
+        piece_on_field = field_get_piece(board[attacker]);
+    }
+
+    // each player captures only if it does not lose material compared to stopping the sequence
+    for (; depth > 0; --depth)
+        gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+    return gains[0];
+}
+
+position_key_t position_key(const board_state_t& board) {
+    position_key_t key = 0u;
+    for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
+         field_idx < static_cast<uint8_t>(field_t::END);
+         ++field_idx) {
+        key ^= piece_key(board[field_idx], static_cast<field_t>(field_idx));
+    }
+    key ^= ZOBRIST_KEYS.castling_rights[board_state_meta_get_castling_rights(board)];
+    key ^= en_passant_key(board);
+    if (PLAYER_WHITE == last_move_get_player(board_state_meta_get_last_move(board)))
+        key ^= ZOBRIST_KEYS.black_to_move;
+    return key;
+}
+
+position_key_t position_key_after_move(const board_state_t& board, const position_key_t key,
+    const move_t move) {
+    position_key_t result = key;
+    const move_s details = describe_move(board, move);
+    const castling_rights_t rights = board_state_meta_get_castling_rights(board);
+    result ^= ZOBRIST_KEYS.black_to_move;
+    result ^= ZOBRIST_KEYS.castling_rights[rights] ^
+        ZOBRIST_KEYS.castling_rights[castling_rights_after_move(rights, details)];
+    result ^= en_passant_key(board) ^ en_passant_key(board, details, opponent(details.player));
+
+    const piece_t piece = MOVE_FLAG_PROMOTION == move_get_flags(move)
+        ? move_get_promotion(move)
+        : details.piece;
+    result ^= piece_key(board[details.from], details.from) ^
+        piece_key(board[details.to], details.to) ^
+        piece_key(field_set_piece(field_set_player(0u, details.player), piece), details.to);
+    switch (move_get_flags(move)) {
+        case MOVE_FLAG_EN_PASSANT: {
+            const field_t captured = en_passant_captured_field(details);
+            result ^= piece_key(board[captured], captured);
+            break;
         }
-        if (PIECE_QUEEN == piece) {
-            moves = fill_diagonal_candidate_moves(moves, board, player, field, piece);
-            moves = fill_cross_candidate_moves(moves, board, player, field, piece);
-            continue;
+        case MOVE_FLAG_CASTLING: {
+            const bool short_castle = details.to > details.from;
+            const field_t rook_from = short_castle
+                ? field_right(details.to)
+                : field_left(field_left(details.to));
+            const field_t rook_to = short_castle ? field_left(details.to) : field_right(details.to);
+            result ^=
+                piece_key(board[rook_from], rook_from) ^ piece_key(board[rook_from], rook_to);
+            break;
         }
-        if (PIECE_KING == piece) {
-            moves = fill_king_candidate_moves(moves, board, player, field);
+    }
+    return result;
+}
+
+position_key_t pawn_key(const board_state_t& board) {
+    position_key_t key = 0u;
+    for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
+         field_idx < static_cast<uint8_t>(field_t::END);
+         ++field_idx) {
+        if (PIECE_PAWN == field_get_piece(board[field_idx]))
+            key ^= piece_key(board[field_idx], static_cast<field_t>(field_idx));
+    }
+    return key;
+}
+
+position_key_t pawn_key_after_move(const board_state_t& board, const position_key_t key,
+    const move_t move) {
+    position_key_t result = key;
+    const move_s details = describe_move(board, move);
+    if (PIECE_PAWN == field_get_piece(board[details.to]))
+        result ^= piece_key(board[details.to], details.to);
+    if (PIECE_PAWN != details.piece)
+        return result;
+
+    result ^= piece_key(board[details.from], details.from);
+    switch (move_get_flags(move)) {
+        case MOVE_FLAG_EN_PASSANT: {
+            const field_t captured = en_passant_captured_field(details);
+            result ^= piece_key(board[details.from], details.to) ^
+                piece_key(board[captured], captured);
+            break;
         }
+        case MOVE_FLAG_PROMOTION: break;
+        default: result ^= piece_key(board[details.from], details.to); break;
     }
-    return moves;
+    return result;
+}
+
+material_key_t material_key(const board_state_t& board) {
+    material_key_t key = 0u;
+    for (const auto field : board)
+        key += material_key_piece(field);
+    return key;
+}
+
+material_key_t material_key_after_move(const board_state_t& board, const material_key_t key,
+    const move_t move) {
+    material_key_t result = key - material_key_piece(board[move_get_to(move)]);
+    const move_s details = describe_move(board, move);
+    switch (move_get_flags(move)) {
+        case MOVE_FLAG_EN_PASSANT:
+            result -= material_key_piece(board[en_passant_captured_field(details)]);
+            break;
+        case MOVE_FLAG_PROMOTION:
+            result += material_key_piece(field_set_piece(board[details.from],
+                move_get_promotion(move))) - material_key_piece(board[details.from]);
+            break;
+    }
+    return result;
+}
+
+constexpr uint8_t material_key_count(const material_key_t key, const player_t player,
+    const piece_t piece) {
+    return (key >> material_key_shift(player, piece)) & 0x0f;
+}
+
+bitboard_t bishop_attacks(const field_t field, const bitboard_t occupied) {
+    return SLIDER_ATTACKS.bishop(field, occupied);
+}
+
+bitboard_t rook_attacks(const field_t field, const bitboard_t occupied) {
+    return SLIDER_ATTACKS.rook(field, occupied);
+}
+
+bool is_square_attacked(const board_state_t& board, const field_t field, const player_t by) {
+    if (field_attacked_by_pawn_or_knight(board, field, by) or
+        field_attacked_by_king(board, field, by))
+        return true;
+
+    const bitboard_t occupied = occupied_fields(board);
+    return ranged_attacker_among(
+            board, bishop_attacks(field, occupied) & occupied, by, PIECE_BISHOP) or
+        ranged_attacker_among(board, rook_attacks(field, occupied) & occupied, by, PIECE_ROOK);
+}
+
+board_state_t apply_move(const board_state_t& board, const move_t move) {
+    board_state_t result = board;
+    const move_s details = describe_move(board, move);
+    undo_t undo;
+    save_move_fields(result, undo, move, details);
+    put_move_pieces(result, move, details);
+    update_fields_under_attack(result, undo);
+    update_last_move(result, details);
+    update_castling_rights(result, details);
+    return result;
+}
+
+void make_move(board_state_t& board, const move_t move, undo_t& undo) {
+    const move_s details = describe_move(board, move);
+    save_move_fields(board, undo, move, details);
+    undo.last_move = board_state_meta_get_last_move(board);
+    undo.castling_rights = board_state_meta_get_castling_rights(board);
+
+    put_move_pieces(board, move, details);
+    undo.attack_flips = update_fields_under_attack(board, undo);
+    update_last_move(board, details);
+    update_castling_rights(board, details);
+}
+
+void unmake_move(board_state_t& board, const undo_t& undo) {
+    for (uint8_t idx = 0; idx < undo.fields_cnt; ++idx) {
+        board[undo.fields[idx]] = undo.field_states[idx];
+    }
+    restore_fields_under_attack(board, undo);
+    board_state_meta_set_last_move(board, undo.last_move);
+    board_state_meta_set_castling_rights(board, undo.castling_rights);
+}
+
+piece_list_t make_piece_list(const board_state_t& board) {
+    piece_list_t pieces = {};
+    pieces.kings = { field_t::INVALID, field_t::INVALID };
+    for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
+         field_idx < static_cast<uint8_t>(field_t::END);
+         ++field_idx) {
+        if (PIECE_EMPTY != field_get_piece(board[field_idx]))
+            piece_list_add(pieces, static_cast<field_t>(field_idx), board[field_idx]);
+    }
+    return pieces;
+}
+
+void make_move(board_state_t& board, const move_t move, undo_t& undo, piece_list_t& pieces) {
+    make_move(board, move, undo);
+    update_piece_list(pieces, board, undo.fields, undo.field_states, undo.fields_cnt);
+}
+
+void unmake_move(board_state_t& board, const undo_t& undo, piece_list_t& pieces) {
+    std::array<field_state_t, 4> states_before;
+    for (uint8_t idx = 0; idx < undo.fields_cnt; ++idx)
+        states_before[idx] = board[undo.fields[idx]];
+    unmake_move(board, undo);
+    update_piece_list(pieces, board, undo.fields, states_before, undo.fields_cnt);
+}
+
+move_t* fill_move_list(move_t* moves, const board_state_t& board, const player_t player,
+    const piece_list_t& pieces) {
+    return PLAYER_WHITE == player
+        ? fill_legal_moves<PLAYER_WHITE>(
+            moves, board, make_legal_info<PLAYER_WHITE>(board, pieces.kings[PLAYER_WHITE]))
+        : fill_legal_moves<PLAYER_BLACK>(
+            moves, board, make_legal_info<PLAYER_BLACK>(board, pieces.kings[PLAYER_BLACK]));
+}
+
+bool is_king_under_attack(const board_state_t& board, const player_t player,
+    const piece_list_t& pieces) {
+    const field_t king = pieces.kings[player];
+    return field_t::INVALID != king and field_under_attack_by(board[king], opponent(player));
 }
 
 bool validate_board_state(const board_state_t& board) {
@@ -1367,18 +3454,8 @@ bool validate_board_state(const board_state_t& board) {
 }
 
 bool compare_simple_position(const board_state_t& lhs, const board_state_t& rhs) {
-    for (uint8_t field_idx = static_cast<uint8_t>(field_t::BEGIN);
-         field_idx < static_cast<uint8_t>(field_t::END);
-         ++field_idx) {
-        auto left_field = lhs[field_idx];
-        auto right_field = rhs[field_idx];
-        if (field_get_piece(left_field) != field_get_piece(right_field) or
-            (PIECE_EMPTY != field_get_piece(left_field) and
-            field_get_player(left_field) != field_get_player(right_field))) {
-            return false;
-        }
-    }
-    return board_state_meta_get_castling_rights(lhs) == board_state_meta_get_castling_rights(rhs);
+    return same_pieces(lhs, rhs) and
+        board_state_meta_get_castling_rights(lhs) == board_state_meta_get_castling_rights(rhs);
 }
 
 /*  @} */ // impl
@@ -1410,8 +3487,8 @@ constexpr field_state_t FBR = field_set_piece(FB, PIECE_ROOK);
 constexpr field_state_t FBQ = field_set_piece(FB, PIECE_QUEEN);
 constexpr field_state_t FBK = field_set_piece(FB, PIECE_KING);
 
-/** Convenient definition of starting chess board */
-constexpr board_state_t START_BOARD =
+/** Convenient definition of starting chess board, with fields under attack set */
+constexpr board_state_t START_BOARD = make_board_state_under_attack(
 {
     FWR, FWN, FWB, FWQ, FWK, FWB, FWN, FWR,
     FWP, FWP, FWP, FWP, FWP, FWP, FWP, FWP,
@@ -1421,7 +3498,7 @@ constexpr board_state_t START_BOARD =
     FF , FF , FF , FF , FF , FF , FF , FF ,
     FBP, FBP, FBP, FBP, FBP, FBP, FBP, FBP,
     FBR, FBN, FBB, FBQ, FBK, FBB, FBN, FBR
-};
+});
 
 /** Convenient definition of empty chess board */
 constexpr board_state_t EMPTY_BOARD =
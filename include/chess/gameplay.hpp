@@ -6,6 +6,7 @@
 #define CHESS_GAMEPLAY_HPP_
 
 #include "chess/core.hpp"
+#include "chess/packed.hpp"
 
 namespace chess
 {
@@ -52,15 +53,15 @@ struct null_log_t {
  *  `black_move_fn` could be switched.
  *
  *  @param log_t - Type of logger to use. By default null-logger is instantiated.
- *  @param memory - Memory that can be used by chess game to allocate move history and candidate
- *                  moves in order to determine whether checkmate occured. Should be enough to
- *                  fit at least 170 `board_state_t`'s (64 bit * 170 = 10 KiB).
+ *  @param memory - Memory that can be used by chess game to allocate move history. Should be
+ *                  enough to fit at least 50 `packed_position_t`'s (36 B * 50 = 1.8 KiB).
  *  @param white_move_fn - Function to handle white player's next move. Function is passed a
  *                         reference to a mutable `board_state_t` representing current position,
  *                         and modification of this data is expected. Function returns type of game
  *                         action (move of forfeit).
  *  @param black_move_fn - as for `white_move_fn` for black player
- *  @param board - starting position on the chessboard
+ *  @param board - starting position on the chessboard, fields under attack are recomputed before
+ *                the game starts
  *
  *  @return Returns `game_result_t` describing game outcome.
  */
@@ -143,62 +144,33 @@ namespace
 {
 
 bool check_draw_by_insufficient_material(const board_state_t& board) {
-    bool white_bishop_found = false;
-    bool white_knight_found = false;
-    bool black_bishop_found = false;
-    bool black_knight_found = false;
-    for (const auto field : board) {
-        switch (field_get_piece(field)) {
-            case PIECE_EMPTY:
-            case PIECE_KING: break;
-            case PIECE_BISHOP: {
-                if (PLAYER_WHITE == field_get_player(field)) {
-                    if (white_bishop_found or white_knight_found) {
-                        return false;
-                    } else {
-                        white_bishop_found = true;
-                    }
-                } else {
-                    if (black_bishop_found or black_knight_found) {
-                        return false;
-                    } else {
-                        black_bishop_found = true;
-                    }
-                }
-                break;
-            }
-            case PIECE_KNIGHT: {
-                if (PLAYER_WHITE == field_get_player(field)) {
-                    if (white_knight_found or white_bishop_found) {
-                        return false;
-                    } else {
-                        white_knight_found = true;
-                    }
-                } else {
-                    if (black_knight_found or black_bishop_found) {
-                        return false;
-                    } else {
-                        black_knight_found = true;
-                    }
-                }
-                break;
-            }
-            default: return false;
-        }
+    // kings with at most one minor piece each, any more pieces are sufficient
+    if (__builtin_popcountll(occupied_fields(board)) > 4)
+        return false;
+
+    const material_key_t material = material_key(board);
+    for (const player_t player : { PLAYER_WHITE, PLAYER_BLACK }) {
+        if (material_key_count(material, player, PIECE_PAWN) or
+            material_key_count(material, player, PIECE_ROOK) or
+            material_key_count(material, player, PIECE_QUEEN) or
+            material_key_count(material, player, PIECE_KNIGHT) +
+                material_key_count(material, player, PIECE_BISHOP) > 1)
+            return false;
     }
     return true;
 }
 
 constexpr std::size_t MOVE_HISTORY_SIZE = 50;
-using move_history_t = detail::ring_buffer_s<board_state_t, MOVE_HISTORY_SIZE>;
+using move_history_t = detail::ring_buffer_s<packed_position_t, MOVE_HISTORY_SIZE>;
 
 bool check_draw_by_threefold_repetition(const board_state_t& board, move_history_t& history) {
+    const packed_position_t position = make_packed_position(board);
     std::size_t same_position_count = 0u;
     RING_BUFFER_FOREACH(history, move_ptr) {
-        if (compare_simple_position(*move_ptr, board) and ++same_position_count > 1 )
+        if (compare_simple_position(*move_ptr, position) and ++same_position_count > 1 )
             return true;
     }
-    ring_buffer_add(history, board);
+    ring_buffer_add(history, position);
     return false;
 }
 
@@ -226,7 +198,7 @@ void update_insignificant_move_cnt(std::size_t& insignificant_move_cnt,
  *  @{
  */
 
-template <typename log_t = null_log_t>
+template <typename log_t>
 game_result_t play(void* memory, request_move_f white_move_fn, request_move_f black_move_fn,
     board_state_t& board, log_t log) {
     if (nullptr == memory or nullptr == white_move_fn or nullptr == black_move_fn) {
@@ -234,21 +206,19 @@ game_result_t play(void* memory, request_move_f white_move_fn, request_move_f bl
         return game_result_t::ERROR;
     }
 
-    board_state_t* move_storage = static_cast<board_state_t*>(memory);
+    packed_position_t* move_storage = static_cast<packed_position_t*>(memory);
 
     move_history_t move_history;
     move_history.storage = move_storage;
 
-    board_state_t* candidate_moves_beg = move_storage + move_history.max_size;
-    board_state_t* candidate_moves_end = candidate_moves_beg;
+    update_fields_under_attack(board);
     board_state_t saved_board = board;
     game_action_t last_action = game_action_t::MOVE;
     std::size_t insignificant_move_cnt = 0;
     std::size_t move_cnt = 0;
     log << "Game started.\n";
     do {
-        candidate_moves_end = fill_candidate_moves(candidate_moves_beg, board, PLAYER_WHITE);
-        if (candidate_moves_end == candidate_moves_beg)
+        if (not has_legal_move(board, PLAYER_WHITE))
             return is_king_under_attack(board, PLAYER_WHITE)
                 ? game_result_t::BLACK_WON_CHECKMATE
                 : game_result_t::DRAW_STALEMATE;
@@ -260,8 +230,9 @@ game_result_t play(void* memory, request_move_f white_move_fn, request_move_f bl
             last_action = white_move_fn(board);
             if (game_action_t::FORFEIT == last_action)
                 return game_result_t::BLACK_WON_FORFEIT;
-            for (auto it = candidate_moves_beg; it != candidate_moves_end; ++it) {
-                if (std::equal(board.begin(), board.end(), it->begin())) {
+            for (const move_t move : legal_moves(saved_board, PLAYER_WHITE)) {
+                const board_state_t candidate_board = apply_move(saved_board, move);
+                if (std::equal(board.begin(), board.end(), candidate_board.begin())) {
                     white_move_valid = true;
                     break;
                 }
@@ -282,8 +253,7 @@ game_result_t play(void* memory, request_move_f white_move_fn, request_move_f bl
 
         saved_board = board;
 
-        candidate_moves_end = fill_candidate_moves(candidate_moves_beg, board, PLAYER_BLACK);
-        if (candidate_moves_end == candidate_moves_beg)
+        if (not has_legal_move(board, PLAYER_BLACK))
             return is_king_under_attack(board, PLAYER_BLACK)
                 ? game_result_t::WHITE_WON_CHECKMATE
                 : game_result_t::DRAW_STALEMATE;
@@ -294,8 +264,9 @@ game_result_t play(void* memory, request_move_f white_move_fn, request_move_f bl
             last_action = black_move_fn(board);
             if (game_action_t::FORFEIT == last_action)
                 return game_result_t::WHITE_WON_FORFEIT;
-            for (auto it = candidate_moves_beg; it != candidate_moves_end; ++it) {
-                if (std::equal(board.begin(), board.end(), it->begin())) {
+            for (const move_t move : legal_moves(saved_board, PLAYER_BLACK)) {
+                const board_state_t candidate_board = apply_move(saved_board, move);
+                if (std::equal(board.begin(), board.end(), candidate_board.begin())) {
                     black_move_valid = true;
                     break;
                 }
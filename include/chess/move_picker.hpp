@@ -0,0 +1,223 @@
+/** move_picker.hpp
+ *
+ * Chess engine staged move generation header-only library.
+ */
+#ifndef CHESS_MOVE_PICKER_HPP_
+#define CHESS_MOVE_PICKER_HPP_
+
+#include <algorithm>
+#include "chess/core.hpp"
+
+namespace chess
+{
+
+/** @defgroup move-picker-types Basic types of staged move generation
+ *  @{
+ */
+
+/** Stages of `move_picker_t`, in the order their moves are yielded */
+enum class move_picker_stage_t {
+    /** Move suggested by the caller, e.g. best move found for the position earlier */
+    HASH_MOVE,
+    /** Captures without promotion, most valuable victim and least valuable attacker first */
+    CAPTURES,
+    /** Promotions, capturing or not, to queen first */
+    PROMOTIONS,
+    /** Quiet moves suggested by the caller, e.g. moves which caused cutoffs in sibling nodes */
+    KILLERS,
+    /** Remaining quiet moves */
+    QUIETS,
+    /** All moves were yielded */
+    DONE
+};
+
+/** Staged move generator
+ *  Yields legal moves of a position one by one. Moves of a stage are generated only once moves of
+ *  the previous stage are exhausted, so a search which cuts off on one of the first moves does not
+ *  pay for generating quiet moves. Every legal move is yielded exactly once.
+ */
+struct move_picker_t {
+    /** Position to generate moves for, has to outlive the picker */
+    const board_state_t* board;
+    /** Player to make one of the moves */
+    player_t player;
+    /** Move yielded first if it is legal in the position, `MOVE_NONE` if there is none */
+    move_t hash_move;
+    /** Quiet moves yielded after promotions if they are legal in the position */
+    std::array<move_t, 2> killer_moves;
+    /** Stage of the move yielded last */
+    move_picker_stage_t stage;
+    /** Index of the next move of current stage in `moves` */
+    uint16_t moves_idx;
+    /** Number of generated moves of current stage */
+    uint16_t moves_cnt;
+    /** Generated moves of current stage */
+    std::array<move_t, 256> moves;
+    /** Checkers and pins of the player's king */
+    detail::legal_info_s legal_info;
+};
+
+/*  @} */ // move-picker-types
+
+/** @defgroup move-picker-api Staged move generation API functions
+ *  @{
+ */
+
+/** Creates staged move generator of a position
+ *
+ *  @param board - `board_state_t` which represents current position on the board.
+ *  @param player - Player to make one of the moves.
+ *  @param hash_move - Move to try first. Does not have to be legal in the position, in which case
+ *                     it is skipped.
+ *  @param killer_moves - Quiet moves to try after captures and promotions. As `hash_move`, they
+ *                        are skipped if they are not legal quiet moves of the position.
+ *
+ *  @return `move_picker_t` to pass to `next_move`.
+ */
+move_picker_t make_move_picker(const board_state_t& board, const player_t player,
+    const move_t hash_move = MOVE_NONE, const std::array<move_t, 2>& killer_moves = {});
+
+/** Returns next legal move of the position
+ *
+ *  @param picker - Staged move generator created with `make_move_picker`. Its `stage` describes
+ *                  the stage of the returned move.
+ *
+ *  @return Next move in the order of `move_picker_stage_t`, `MOVE_NONE` after the last one.
+ */
+move_t next_move(move_picker_t& picker);
+
+/*  @} */ // move-picker-api
+
+/** @defgroup move-picker-private-impl Private implementation
+ *  @{
+ */
+namespace
+{
+
+/** Piece values used to order captures, indexed with `piece_t` */
+constexpr std::array<uint8_t, PIECE_KING + 1> MOVE_PICKER_PIECE_VALUES = {
+    0, 1, 3, 3, 5, 9, 10
+};
+
+/** Most valuable victim, least valuable attacker score of a capture */
+uint8_t capture_score(const board_state_t& board, const move_t move) {
+    const piece_t victim = MOVE_FLAG_EN_PASSANT == move_get_flags(move)
+        ? PIECE_PAWN
+        : field_get_piece(board[move_get_to(move)]);
+    const piece_t attacker = field_get_piece(board[move_get_from(move)]);
+    return MOVE_PICKER_PIECE_VALUES[victim] * 16 - MOVE_PICKER_PIECE_VALUES[attacker];
+}
+
+/** Checks whether `move` is one of moves of `KINDS` the piece on its source field can make */
+template <player_t P, move_kinds_t KINDS>
+bool move_pseudo_legal(const board_state_t& board, const move_t move) {
+    const field_t from = move_get_from(move);
+    if (MOVE_NONE == move or PIECE_EMPTY == field_get_piece(board[from]) or
+        P != field_get_player(board[from]))
+        return false;
+
+    move_t moves[32];
+    move_t* moves_end = fill_piece_moves<P, KINDS>(moves, board, from, player_fields(board));
+    return moves_end != std::find(moves, moves_end, move);
+}
+
+template <player_t P>
+void fill_move_picker_stage(move_picker_t& picker) {
+    const board_state_t& board = *picker.board;
+    move_t* moves = picker.moves.data();
+    move_t* moves_end = moves;
+    switch (picker.stage) {
+        case move_picker_stage_t::HASH_MOVE:
+            if (move_pseudo_legal<P, MOVE_KIND_ALL>(board, picker.hash_move))
+                *moves_end++ = picker.hash_move;
+            break;
+        case move_picker_stage_t::CAPTURES:
+            moves_end = fill_pseudo_legal_moves<P, MOVE_KIND_CAPTURES>(moves, board);
+            std::stable_sort(moves, moves_end, [&board](const move_t lhs, const move_t rhs) {
+                return capture_score(board, lhs) > capture_score(board, rhs);
+            });
+            break;
+        case move_picker_stage_t::PROMOTIONS:
+            moves_end = fill_pseudo_legal_moves<P, MOVE_KIND_PROMOTIONS>(moves, board);
+            std::stable_sort(moves, moves_end, [](const move_t lhs, const move_t rhs) {
+                return move_get_promotion(lhs) > move_get_promotion(rhs);
+            });
+            break;
+        case move_picker_stage_t::KILLERS:
+            for (const auto killer_move : picker.killer_moves) {
+                if (killer_move != picker.hash_move and moves_end == std::find(moves, moves_end,
+                        killer_move) and
+                    move_pseudo_legal<P, MOVE_KIND_QUIETS>(board, killer_move))
+                    *moves_end++ = killer_move;
+            }
+            break;
+        case move_picker_stage_t::QUIETS:
+            moves_end = fill_pseudo_legal_moves<P, MOVE_KIND_QUIETS>(moves, board);
+            break;
+        case move_picker_stage_t::DONE: break;
+    }
+    picker.moves_idx = 0;
+    picker.moves_cnt = static_cast<uint16_t>(moves_end - moves);
+}
+
+/** Checks whether `move` was already yielded by an earlier stage of the picker */
+bool move_picked_before(const move_picker_t& picker, const move_t move) {
+    if (move_picker_stage_t::HASH_MOVE != picker.stage and picker.hash_move == move)
+        return true;
+    return move_picker_stage_t::QUIETS == picker.stage and
+        (picker.killer_moves[0] == move or picker.killer_moves[1] == move);
+}
+
+template <player_t P>
+move_t next_move(move_picker_t& picker) {
+    while (true) {
+        while (picker.moves_idx < picker.moves_cnt) {
+            const move_t move = picker.moves[picker.moves_idx++];
+            if (not move_picked_before(picker, move) and
+                move_legal<P>(*picker.board, picker.legal_info, move))
+                return move;
+        }
+        if (move_picker_stage_t::DONE == picker.stage)
+            return MOVE_NONE;
+        picker.stage = static_cast<move_picker_stage_t>(static_cast<int>(picker.stage) + 1);
+        fill_move_picker_stage<P>(picker);
+    }
+}
+
+}  // namespace
+
+/*  @} */ // move-picker-private-impl
+
+/** @defgroup move-picker-impl Implementation of public functions
+ *  @{
+ */
+
+move_picker_t make_move_picker(const board_state_t& board, const player_t player,
+    const move_t hash_move, const std::array<move_t, 2>& killer_moves) {
+    move_picker_t picker;
+    picker.board = &board;
+    picker.player = player;
+    picker.hash_move = hash_move;
+    picker.killer_moves = killer_moves;
+    picker.stage = move_picker_stage_t::HASH_MOVE;
+    if (PLAYER_WHITE == player) {
+        picker.legal_info = make_legal_info<PLAYER_WHITE>(board);
+        fill_move_picker_stage<PLAYER_WHITE>(picker);
+    } else {
+        picker.legal_info = make_legal_info<PLAYER_BLACK>(board);
+        fill_move_picker_stage<PLAYER_BLACK>(picker);
+    }
+    return picker;
+}
+
+move_t next_move(move_picker_t& picker) {
+    return PLAYER_WHITE == picker.player
+        ? next_move<PLAYER_WHITE>(picker)
+        : next_move<PLAYER_BLACK>(picker);
+}
+
+/*  @} */ // move-picker-impl
+
+}  // namespace chess
+
+#endif  // CHESS_MOVE_PICKER_HPP_
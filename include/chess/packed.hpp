@@ -0,0 +1,200 @@
+/** packed.hpp
+ *
+ * Chess engine packed position representation header-only library.
+ */
+#ifndef CHESS_PACKED_HPP_
+#define CHESS_PACKED_HPP_
+
+#include <algorithm>
+#include "chess/core.hpp"
+
+namespace chess
+{
+
+/** @defgroup packed-types Basic types of packed representation
+ *  @{
+ */
+
+/** Packed position type
+ *  Storage format of a position, for caches and game histories. Keeps only what is not transient
+ *  in `board_state_t` - player and piece of every field in 4 bits, two fields per byte, and the
+ *  last move and castling rights from the meta bits. Fields under attack are recomputed when the
+ *  position is unpacked. Empty fields are always packed as zero, so two packed positions with the
+ *  same pieces have the same bytes.
+ */
+struct packed_position_t {
+    /** Player and piece bits of fields, lower nibble of byte N is field 2N, upper one 2N + 1 */
+    std::array<uint8_t, 32> fields;
+    /** Last move made, same encoding as in `board_state_t` meta bits */
+    last_move_t last_move;
+    /** Castling rights, same encoding as in `board_state_t` meta bits */
+    castling_rights_t castling_rights;
+};
+
+static_assert(36 == sizeof(packed_position_t), "packed_position_t has to be exactly 36 bytes");
+
+/*  @} */ // packed-types
+
+/** @defgroup packed-api Packed representation API functions
+ *  @{
+ */
+
+/** Packs `board_state_t` into 36 bytes
+ *
+ *  @param board - `board_state_t` which represents current position on the board.
+ *
+ *  @return `packed_position_t` with pieces, last move and castling rights of the position.
+ */
+packed_position_t make_packed_position(const board_state_t& board);
+
+/** Unpacks packed representation back to `board_state_t`
+ *
+ *  @param position - `packed_position_t` which represents current position on the board.
+ *
+ *  @return `board_state_t` with pieces, last move and castling rights of the position. Fields
+ *          under attack are recomputed, so the result can be passed directly to
+ *          `fill_candidate_moves`.
+ */
+board_state_t make_board_state(const packed_position_t& position);
+
+/** Compares two packed positions for threefold repetition purposes
+ *
+ *  @return `true` if pieces and castling rights are the same, `false` otherwise. Same as
+ *          `compare_simple_position` of the unpacked positions.
+ */
+bool compare_simple_position(const packed_position_t& lhs, const packed_position_t& rhs);
+
+/*  @} */ // packed-api
+
+/** @defgroup packed-private-impl Private implementation
+ *  @{
+ */
+namespace
+{
+
+/** Packs player and piece bits of 64 fields into nibbles, empty fields as zero
+ *  With AVX2 or SSE2 enabled the fields are masked and pairs of them merged in 16-bit lanes of
+ *  vectors, which are then narrowed to bytes with unsigned saturation.
+ */
+void pack_fields(std::array<uint8_t, 32>& packed, const board_state_t& board) {
+    constexpr auto FIELD_BITS = FIELD_PLAYER_DESC.mask | FIELD_PIECE_DESC.mask;
+#if defined(__AVX2__) && !defined(CHESS_SIMD_NONE)
+    const __m256i field_mask = _mm256_set1_epi8(static_cast<char>(FIELD_BITS));
+    const __m256i piece_mask = _mm256_set1_epi8(static_cast<char>(FIELD_PIECE_DESC.mask));
+    const __m256i lane_mask = _mm256_set1_epi16(0x00FF);
+    __m256i pairs[2];
+    for (std::size_t idx = 0; idx < 2; ++idx) {
+        const __m256i fields = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(board.data() + idx * sizeof(__m256i)));
+        const __m256i empty =
+            _mm256_cmpeq_epi8(_mm256_and_si256(fields, piece_mask), _mm256_setzero_si256());
+        const __m256i nibbles = _mm256_andnot_si256(empty, _mm256_and_si256(fields, field_mask));
+        // odd field of every pair moves from bits 8-11 to bits 4-7 of the 16-bit lane
+        pairs[idx] = _mm256_and_si256(
+            _mm256_or_si256(nibbles, _mm256_srli_epi16(nibbles, 4)), lane_mask);
+    }
+    // narrowing interleaves 128-bit halves of both vectors, 64-bit quarters are put back in order
+    const __m256i result =
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(pairs[0], pairs[1]), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(packed.data()), result);
+#elif defined(__SSE2__) && !defined(CHESS_SIMD_NONE)
+    const __m128i field_mask = _mm_set1_epi8(static_cast<char>(FIELD_BITS));
+    const __m128i piece_mask = _mm_set1_epi8(static_cast<char>(FIELD_PIECE_DESC.mask));
+    const __m128i lane_mask = _mm_set1_epi16(0x00FF);
+    __m128i pairs[4];
+    for (std::size_t idx = 0; idx < 4; ++idx) {
+        const __m128i fields = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(board.data() + idx * sizeof(__m128i)));
+        const __m128i empty =
+            _mm_cmpeq_epi8(_mm_and_si128(fields, piece_mask), _mm_setzero_si128());
+        const __m128i nibbles = _mm_andnot_si128(empty, _mm_and_si128(fields, field_mask));
+        // odd field of every pair moves from bits 8-11 to bits 4-7 of the 16-bit lane
+        pairs[idx] = _mm_and_si128(_mm_or_si128(nibbles, _mm_srli_epi16(nibbles, 4)), lane_mask);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(packed.data()),
+        _mm_packus_epi16(pairs[0], pairs[1]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(packed.data() + sizeof(__m128i)),
+        _mm_packus_epi16(pairs[2], pairs[3]));
+#else
+    auto nibble = [](const field_state_t field) {
+        return field_empty(field) ? 0u : field & FIELD_BITS;
+    };
+    for (std::size_t idx = 0; idx < packed.size(); ++idx) {
+        packed[idx] = static_cast<uint8_t>(
+            nibble(board[2 * idx]) | nibble(board[2 * idx + 1]) << 4);
+    }
+#endif
+}
+
+/** Unpacks nibbles of 64 fields into `board_state_t` fields with attack and meta bits cleared
+ *  With AVX2 or SSE2 enabled lower and upper nibbles are split into two vectors and interleaved
+ *  back into fields.
+ */
+void unpack_fields(board_state_t& board, const std::array<uint8_t, 32>& packed) {
+#if defined(__AVX2__) && !defined(CHESS_SIMD_NONE)
+    const __m256i nibble_mask = _mm256_set1_epi8(0x0F);
+    const __m256i nibbles =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(packed.data()));
+    const __m256i even = _mm256_and_si256(nibbles, nibble_mask);
+    const __m256i odd = _mm256_and_si256(_mm256_srli_epi16(nibbles, 4), nibble_mask);
+    // interleaving works within 128-bit halves, they hold fields 0-15 and 32-47, 16-31 and 48-63
+    const __m256i low = _mm256_unpacklo_epi8(even, odd);
+    const __m256i high = _mm256_unpackhi_epi8(even, odd);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(board.data()),
+        _mm256_permute2x128_si256(low, high, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(board.data() + sizeof(__m256i)),
+        _mm256_permute2x128_si256(low, high, 0x31));
+#elif defined(__SSE2__) && !defined(CHESS_SIMD_NONE)
+    const __m128i nibble_mask = _mm_set1_epi8(0x0F);
+    for (std::size_t idx = 0; idx < 2; ++idx) {
+        const __m128i nibbles = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(packed.data() + idx * sizeof(__m128i)));
+        const __m128i even = _mm_and_si128(nibbles, nibble_mask);
+        const __m128i odd = _mm_and_si128(_mm_srli_epi16(nibbles, 4), nibble_mask);
+        auto* fields = reinterpret_cast<__m128i*>(board.data() + idx * 2 * sizeof(__m128i));
+        _mm_storeu_si128(fields, _mm_unpacklo_epi8(even, odd));
+        _mm_storeu_si128(fields + 1, _mm_unpackhi_epi8(even, odd));
+    }
+#else
+    for (std::size_t idx = 0; idx < packed.size(); ++idx) {
+        board[2 * idx] = packed[idx] & 0x0F;
+        board[2 * idx + 1] = packed[idx] >> 4;
+    }
+#endif
+}
+
+}  // namespace
+
+/*  @} */ // packed-private-impl
+
+/** @defgroup packed-impl Implementation of public functions
+ *  @{
+ */
+
+packed_position_t make_packed_position(const board_state_t& board) {
+    packed_position_t position = {};
+    pack_fields(position.fields, board);
+    position.last_move = board_state_meta_get_last_move(board);
+    position.castling_rights = board_state_meta_get_castling_rights(board);
+    return position;
+}
+
+board_state_t make_board_state(const packed_position_t& position) {
+    board_state_t board;
+    unpack_fields(board, position.fields);
+    board_state_meta_set_last_move(board, position.last_move);
+    board_state_meta_set_castling_rights(board, position.castling_rights);
+    update_fields_under_attack(board);
+    return board;
+}
+
+bool compare_simple_position(const packed_position_t& lhs, const packed_position_t& rhs) {
+    return std::equal(lhs.fields.begin(), lhs.fields.end(), rhs.fields.begin()) and
+        lhs.castling_rights == rhs.castling_rights;
+}
+
+/*  @} */ // packed-impl
+
+}  // namespace chess
+
+#endif  // CHESS_PACKED_HPP_
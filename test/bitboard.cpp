@@ -0,0 +1,183 @@
+#include <memory>
+#include <algorithm>
+#include "chess/bitboard.hpp"
+#include "chesstest.hpp"
+#include "test_boards.hpp"
+
+using namespace chess;
+
+bool same_candidate_moves(const board_state_t& board, const player_t player) {
+    auto c_moves = std::make_unique<board_state_t[]>(256);
+    auto c_moves_end = fill_candidate_moves(c_moves.get(), board, player);
+
+    auto bb_moves = std::make_unique<bitboard_position_t[]>(256);
+    auto bb_moves_end = fill_candidate_moves(bb_moves.get(), make_bitboard_position(board, player));
+
+    test_output << c_moves_end - c_moves.get() << " candidate moves, "
+        << bb_moves_end - bb_moves.get() << " bitboard candidate moves.\n";
+    if (c_moves_end - c_moves.get() != bb_moves_end - bb_moves.get())
+        return false;
+
+    return std::all_of(bb_moves.get(), bb_moves_end, [&](const auto& position) {
+        const auto board = make_board_state(position);
+        return c_moves_end != std::find_if(c_moves.get(), c_moves_end, [&](const auto& move) {
+            return same_position(board, move);
+        });
+    });
+}
+
+std::size_t perft(const bitboard_position_t& position, const int depth) {
+    bitboard_position_t moves[256];
+    auto moves_end = fill_candidate_moves(moves, position);
+    if (1 == depth)
+        return moves_end - moves;
+
+    std::size_t nodes = 0;
+    for (auto it = moves; it != moves_end; ++it)
+        nodes += perft(*it, depth - 1);
+    return nodes;
+}
+
+std::size_t perft(const board_state_t& board, const player_t player, const int depth) {
+    board_state_t moves[256];
+    auto moves_end = fill_candidate_moves(moves, board, player);
+    if (1 == depth)
+        return moves_end - moves;
+
+    std::size_t nodes = 0;
+    for (auto it = moves; it != moves_end; ++it)
+        nodes += perft(*it, opponent(player), depth - 1);
+    return nodes;
+}
+
+TEST(Bitboard_StaticEvaluation_Helpers) {
+    static_assert(1ull == field_bit(A1), "A1 is the lowest bit");
+    static_assert(1ull << 63 == field_bit(H8), "H8 is the highest bit");
+    static_assert(3u == bitboard_count(field_bit(A1) | field_bit(D4) | field_bit(H8)),
+        "Three fields in a set");
+    static_assert(D4 == bitboard_first(field_bit(D4) | field_bit(H8)), "D4 is the lowest field");
+}
+
+TEST(Bitboard_Conversion_StartBoard) {
+    auto board = START_BOARD;
+    update_fields_under_attack(board);
+    const auto position = make_bitboard_position(board, PLAYER_WHITE);
+
+    ASSERT(16u == bitboard_count(position.players[PLAYER_WHITE]));
+    ASSERT(16u == bitboard_count(position.players[PLAYER_BLACK]));
+    ASSERT(16u == bitboard_count(position.pieces[PIECE_PAWN]));
+    ASSERT((field_bit(E1) | field_bit(E8)) == position.pieces[PIECE_KING]);
+    ASSERT(PLAYER_WHITE == position.header.side_to_move);
+    ASSERT(field_t::INVALID == position.header.en_passant);
+    ASSERT(std::equal(board.begin(), board.end(), make_board_state(position).begin()));
+}
+
+TEST(Bitboard_Conversion_RoundTripKeepsMetaState) {
+    auto board = kiwipete_board();
+    board_state_meta_set_castling_rights(board, CASTLING_RIGHTS_WHITE_LONG);
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, C7, C5 });
+    const auto position = make_bitboard_position(board, PLAYER_WHITE);
+
+    ASSERT(C6 == position.header.en_passant);
+    ASSERT(CASTLING_RIGHTS_WHITE_LONG == position.header.castling_rights);
+    ASSERT(same_position(board, make_board_state(position)));
+}
+
+TEST(Bitboard_Conversion_NoEnPassantForOwnPawnMove) {
+    auto board = kiwipete_board();
+    apply_move_if_valid(&board, { PLAYER_WHITE, PIECE_PAWN, A2, A4 });
+
+    ASSERT(A3 == make_bitboard_position(board, PLAYER_BLACK).header.en_passant);
+    ASSERT(field_t::INVALID == make_bitboard_position(board, PLAYER_WHITE).header.en_passant);
+}
+
+TEST(Bitboard_CandidateMoves_HalfmoveClock) {
+    const auto position = make_bitboard_position(kiwipete_board(), PLAYER_WHITE, 7);
+    bitboard_position_t moves[256];
+    const auto moves_end = fill_candidate_moves(moves, position);
+
+    ASSERT(7u == position.header.halfmove_clock);
+    for (auto move = moves; move != moves_end; ++move) {
+        const field_t from = last_move_get_from(move->header.last_move);
+        const field_t to = last_move_get_to(move->header.last_move);
+        const bool resets = PIECE_PAWN == last_move_get_piece(move->header.last_move) or
+            (position.players[PLAYER_BLACK] & field_bit(to));
+        test_output << from << "-" << to << ": " << +move->header.halfmove_clock << "\n";
+        ASSERT((resets ? 0u : 8u) == move->header.halfmove_clock);
+    }
+
+    const auto saturated = make_bitboard_position(START_BOARD, PLAYER_WHITE, UINT8_MAX);
+    fill_candidate_moves(moves, saturated);
+    ASSERT(PIECE_KNIGHT == last_move_get_piece(moves[16].header.last_move));
+    ASSERT(UINT8_MAX == moves[16].header.halfmove_clock);
+}
+
+TEST(Bitboard_CandidateMoves_SameAsBoardState_StartBoard) {
+    auto board = START_BOARD;
+    update_fields_under_attack(board);
+    ASSERT(same_candidate_moves(board, PLAYER_WHITE));
+    ASSERT(same_candidate_moves(board, PLAYER_BLACK));
+}
+
+TEST(Bitboard_CandidateMoves_SameAsBoardState_Castling) {
+    const auto board = kiwipete_board();
+    ASSERT(same_candidate_moves(board, PLAYER_WHITE));
+    ASSERT(same_candidate_moves(board, PLAYER_BLACK));
+}
+
+TEST(Bitboard_CandidateMoves_SameAsBoardState_EnPassant) {
+    auto board = kiwipete_board();
+    apply_move_if_valid(&board, { PLAYER_WHITE, PIECE_PAWN, A2, A4 });
+    ASSERT(same_candidate_moves(board, PLAYER_BLACK));
+}
+
+TEST(Bitboard_CandidateMoves_SameAsBoardState_Promotions) {
+    const auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[H8] = FBK;
+        board[B7] = FWP;
+        board[A8] = FBR;
+        board[C8] = FBN;
+        board[G2] = FBP;
+        board[F1] = FWB;
+    });
+    ASSERT(same_candidate_moves(board, PLAYER_WHITE));
+    ASSERT(same_candidate_moves(board, PLAYER_BLACK));
+}
+
+TEST(Bitboard_CandidateMoves_SameAsBoardState_PinsAndChecks) {
+    const auto board = prepare_board([](auto& board) {
+        board[E8] = FBK;
+        board[E4] = FWK;
+        board[D4] = FWP;
+        board[F5] = FWN;
+        board[A4] = FBR;
+        board[H7] = FBB;
+        board[C5] = FBP;
+    });
+    ASSERT(same_candidate_moves(board, PLAYER_WHITE));
+    ASSERT(same_candidate_moves(board, PLAYER_BLACK));
+}
+
+TEST(Bitboard_Perft_StartBoard) {
+    auto board = START_BOARD;
+    update_fields_under_attack(board);
+    const auto position = make_bitboard_position(board, PLAYER_WHITE);
+
+    ASSERT(20u == perft(position, 1));
+    ASSERT(400u == perft(position, 2));
+    ASSERT(8902u == perft(position, 3));
+    ASSERT(197281u == perft(position, 4));
+    ASSERT(8902u == perft(board, PLAYER_WHITE, 3));
+}
+
+TEST(Bitboard_Perft_Kiwipete) {
+    const auto board = kiwipete_board();
+    const auto position = make_bitboard_position(board, PLAYER_WHITE);
+
+    ASSERT(48u == perft(position, 1));
+    ASSERT(2039u == perft(position, 2));
+    ASSERT(97862u == perft(position, 3));
+    ASSERT(2039u == perft(board, PLAYER_WHITE, 2));
+    ASSERT(97862u == perft(board, PLAYER_WHITE, 3));
+}
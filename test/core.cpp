@@ -1,7 +1,9 @@
 #include <memory>
 #include <algorithm>
+#include <vector>
 #include "chess/core.hpp"
 #include "chesstest.hpp"
+#include "test_boards.hpp"
 
 using namespace chess;
 
@@ -12,14 +14,6 @@ static void temp_print_c_moves(const board_state_t* c_moves_beg, const board_sta
     test_output << c_moves_end - c_moves_beg << " candidate moves.\n";
 }
 
-board_state_t prepare_board(std::function<void(board_state_t&)> setup_fn) {
-    auto board = chess::EMPTY_BOARD;
-    setup_fn(board);
-    update_fields_under_attack(board);
-    // draw_board(board);
-    return board;
-}
-
 std::unique_ptr<board_state_t[]> prepare_moves() {
     return std::make_unique<board_state_t[]>(64);
 }
@@ -451,6 +445,100 @@ TEST(CandidateMoves_Pawn_Black_MoveForward_Queening) {
         std::find(transformed_pieces.begin(), transformed_pieces.end(), PIECE_QUEEN));
 }
 
+TEST(CandidateMoves_Pawn_Black_MoveForward_Queening_NoExtraMoves) {
+    auto board = one_pawn_board(A2, FBP);
+    auto c_moves = prepare_moves();
+    const auto* c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_BLACK);
+
+    ASSERT(all_candidate_moves_are_valid(c_moves.get(), c_moves_end));
+    ASSERT(9 == c_moves_end - c_moves.get()); // 4 promotions and 5 king moves
+}
+
+std::vector<piece_t> promoted_pieces(
+    const board_state_t* c_moves_beg, const board_state_t* c_moves_end, const move_s& move) {
+    std::vector<piece_t> pieces;
+    for (auto it = c_moves_beg; it != c_moves_end; ++it) {
+        if (check_last_move(*it, move))
+            pieces.push_back(field_get_piece((*it)[move.to]));
+    }
+    std::sort(pieces.begin(), pieces.end());
+    return pieces;
+}
+
+TEST(CandidateMoves_Pawn_White_CaptureLeftUp_Queening) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[E8] = FBK;
+        board[B7] = FWP;
+        board[A8] = FBN;
+    });
+    auto c_moves = prepare_moves();
+    const auto* c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_WHITE);
+
+    ASSERT(all_candidate_moves_are_valid(c_moves.get(), c_moves_end));
+    ASSERT((std::vector<piece_t>{ PIECE_KNIGHT, PIECE_BISHOP, PIECE_ROOK, PIECE_QUEEN } ==
+        promoted_pieces(c_moves.get(), c_moves_end, { PLAYER_WHITE, PIECE_PAWN, B7, A8 })));
+}
+
+TEST(CandidateMoves_Pawn_Black_CaptureRightDown_Queening) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[E8] = FBK;
+        board[G2] = FBP;
+        board[H1] = FWN;
+    });
+    auto c_moves = prepare_moves();
+    const auto* c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_BLACK);
+
+    ASSERT(all_candidate_moves_are_valid(c_moves.get(), c_moves_end));
+    ASSERT((std::vector<piece_t>{ PIECE_KNIGHT, PIECE_BISHOP, PIECE_ROOK, PIECE_QUEEN } ==
+        promoted_pieces(c_moves.get(), c_moves_end, { PLAYER_BLACK, PIECE_PAWN, G2, H1 })));
+}
+
+const board_state_t* find_promotion(const board_state_t* c_moves_beg,
+    const board_state_t* c_moves_end, const move_s& move, const piece_t promote_to) {
+    return std::find_if(c_moves_beg, c_moves_end, [&](const auto& board) {
+        return check_last_move(board, move) and promote_to == field_get_piece(board[move.to]);
+    });
+}
+
+TEST(CandidateMoves_Pawn_White_MoveForward_Queening_AttacksOfPromotedPiece) {
+    auto board = one_pawn_board(A7);
+    auto c_moves = prepare_moves();
+    const auto* c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_WHITE);
+
+    const auto* queen = find_promotion(
+        c_moves.get(), c_moves_end, { PLAYER_WHITE, PIECE_PAWN, A7, A8 }, PIECE_QUEEN);
+    ASSERT(c_moves_end != queen);
+    ASSERT(field_under_white_attack((*queen)[D8]));
+    ASSERT(field_under_white_attack((*queen)[A1]));
+
+    const auto* knight = find_promotion(
+        c_moves.get(), c_moves_end, { PLAYER_WHITE, PIECE_PAWN, A7, A8 }, PIECE_KNIGHT);
+    ASSERT(c_moves_end != knight);
+    ASSERT(field_under_white_attack((*knight)[C7]));
+    ASSERT(!field_under_white_attack((*knight)[B8]));
+}
+
+TEST(CandidateMoves_Pawn_Black_MoveForward_Queening_AttacksOfPromotedPiece) {
+    auto board = one_pawn_board(H2, FBP);
+    auto c_moves = prepare_moves();
+    const auto* c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_BLACK);
+
+    const auto* rook = find_promotion(
+        c_moves.get(), c_moves_end, { PLAYER_BLACK, PIECE_PAWN, H2, H1 }, PIECE_ROOK);
+    ASSERT(c_moves_end != rook);
+    ASSERT(field_under_black_attack((*rook)[F1]));
+    ASSERT(field_under_black_attack((*rook)[H8]));
+    ASSERT(field_under_black_attack((*rook)[G1]));
+
+    const auto* bishop = find_promotion(
+        c_moves.get(), c_moves_end, { PLAYER_BLACK, PIECE_PAWN, H2, H1 }, PIECE_BISHOP);
+    ASSERT(c_moves_end != bishop);
+    ASSERT(field_under_black_attack((*bishop)[C6]));
+    ASSERT(!field_under_black_attack((*bishop)[G1]));
+}
+
 auto three_piece_board(
     const field_t piece1_pos, const field_state_t piece1,
     const field_t piece2_pos, const field_state_t piece2,
@@ -941,6 +1029,46 @@ TEST(CandidateMoves_King_Black_LongCastlingRightsLostByRook) {
     ASSERT(!check_candidate_move(c_moves_beg, c_moves_end, { PLAYER_BLACK, PIECE_KING, E8, C8 }));
 }
 
+TEST(CandidateMoves_King_White_LongCastlingRightsLostByRookCaptured) {
+    auto board = prepare_board([](auto& board) {
+        board[E8] = FBK;
+        board[G7] = FBB;
+        board[E1] = FWK;
+        board[A1] = FWR;
+        board[H1] = FWR;
+    });
+
+    auto c_moves = prepare_moves();
+    const auto* c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_BLACK);
+    const auto* found_move = find_candidate_move(
+        c_moves.get(), c_moves_end, { PLAYER_BLACK, PIECE_BISHOP, G7, A1 });
+
+    ASSERT(c_moves_end != found_move);
+    const auto rights = board_state_meta_get_castling_rights(*found_move);
+    ASSERT(castling_rights_white_short(rights));
+    ASSERT(!castling_rights_white_long(rights));
+}
+
+TEST(CandidateMoves_King_Black_ShortCastlingRightsLostByRookCaptured) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[B2] = FWB;
+        board[E8] = FBK;
+        board[A8] = FBR;
+        board[H8] = FBR;
+    });
+
+    auto c_moves = prepare_moves();
+    const auto* c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_WHITE);
+    const auto* found_move = find_candidate_move(
+        c_moves.get(), c_moves_end, { PLAYER_WHITE, PIECE_BISHOP, B2, H8 });
+
+    ASSERT(c_moves_end != found_move);
+    const auto rights = board_state_meta_get_castling_rights(*found_move);
+    ASSERT(!castling_rights_black_short(rights));
+    ASSERT(castling_rights_black_long(rights));
+}
+
 TEST(CandidateMoves_King_White_ShortCastleNotPermittedDueToF1Attacked) {
     auto board = prepare_board([](auto& board) {
         board[A8] = FBK;
@@ -1094,6 +1222,21 @@ TEST(CandidateMoves_King_Black_LongCastleNotPermittedDueToC8Attacked) {
     ASSERT(!check_candidate_move(c_moves_beg, c_moves_end, { PLAYER_WHITE, PIECE_KING, E1, C1 }));
 }
 
+TEST(CandidateMoves_King_Black_LongCastleNotPermittedDueToD8AttackedWhenBlackMoves) {
+    auto board = prepare_board([](auto& board) {
+        board[E8] = FBK;
+        board[A8] = FBR;
+        board[H1] = FWK;
+        board[G5] = FWB;
+    });
+    auto c_moves = prepare_moves();
+    const auto* c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_BLACK);
+    const auto* c_moves_beg = c_moves.get();
+
+    ASSERT(all_candidate_moves_are_valid(c_moves.get(), c_moves_end));
+    ASSERT(!check_candidate_move(c_moves_beg, c_moves_end, { PLAYER_BLACK, PIECE_KING, E8, C8 }));
+}
+
 TEST(Validation_White_Checkmate_ShouldResultIn0CandidateMoves) {
     auto board = prepare_board([](auto& board) {
         board[A1] = FWK;
@@ -1291,4 +1434,1067 @@ TEST(Validation_Black_CannotMoveKingNearKing) {
     temp_print_c_moves(c_moves_beg, c_moves_end);
     ASSERT(1u == (c_moves_end - c_moves_beg));
     ASSERT(check_candidate_move(c_moves_beg, c_moves_end, { PLAYER_BLACK, PIECE_KING, A8, B8 }));
-}
\ No newline at end of file
+}
+TEST(Internal_StaticEvaluation_MoveEncoding) {
+    constexpr move_t move = encode_move(E2, E4, MOVE_FLAG_NONE);
+    static_assert(E2 == move_get_from(move), "E2E4 from E2");
+    static_assert(E4 == move_get_to(move), "E2E4 to E4");
+    static_assert(MOVE_FLAG_NONE == move_get_flags(move), "E2E4 is a regular move");
+    static_assert(PIECE_EMPTY == move_get_promotion(move), "E2E4 is not a promotion");
+
+    constexpr move_t promotion =
+        move_set_promotion(encode_move(H7, G8, MOVE_FLAG_NONE), PIECE_ROOK);
+    static_assert(H7 == move_get_from(promotion), "H7G8=R from H7");
+    static_assert(G8 == move_get_to(promotion), "H7G8=R to G8");
+    static_assert(MOVE_FLAG_PROMOTION == move_get_flags(promotion), "H7G8=R is a promotion");
+    static_assert(PIECE_ROOK == move_get_promotion(promotion), "H7G8=R promotes to rook");
+
+    static_assert(MOVE_FLAG_CASTLING == move_get_flags(encode_move(E8, C8, MOVE_FLAG_CASTLING)),
+        "E8C8 castling flag");
+    static_assert(2u == sizeof(move_t), "Move fits in 2 bytes");
+}
+
+bool move_list_matches_candidate_moves(const board_state_t& board, const player_t player) {
+    auto c_moves = std::make_unique<board_state_t[]>(256);
+    const board_state_t* c_moves_beg = c_moves.get();
+    const board_state_t* c_moves_end = fill_candidate_moves(c_moves.get(), board, player);
+    move_t move_list[256];
+    const move_t* move_list_end = fill_move_list(move_list, board, player);
+
+    temp_print_c_moves(c_moves_beg, c_moves_end);
+    test_output << move_list_end - move_list << " moves in move list.\n";
+    if (c_moves_end - c_moves_beg != move_list_end - move_list)
+        return false;
+
+    const move_t* move_list_beg = move_list;
+    return std::all_of(move_list_beg, move_list_end, [&](const move_t move) {
+        const auto child = apply_move(board, move);
+        return c_moves_end != std::find_if(c_moves_beg, c_moves_end, [&](const auto& c_move) {
+            return std::equal(child.begin(), child.end(), c_move.begin());
+        });
+    });
+}
+
+TEST(MoveList_SameAsCandidateMoves_StartBoard) {
+    auto board = prepare_board([](auto& board) { board = START_BOARD; });
+    ASSERT(move_list_matches_candidate_moves(board, PLAYER_WHITE));
+    ASSERT(move_list_matches_candidate_moves(board, PLAYER_BLACK));
+}
+
+TEST(MoveList_SameAsCandidateMoves_CastlingAndPromotions) {
+    const auto board = castling_promotions_board();
+    ASSERT(move_list_matches_candidate_moves(board, PLAYER_WHITE));
+    ASSERT(move_list_matches_candidate_moves(board, PLAYER_BLACK));
+}
+
+TEST(MoveList_SameAsCandidateMoves_EnPassantAndPins) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[E5] = FWP;
+        board[F5] = FWR;
+        board[H5] = FBK;
+        board[D7] = FBP;
+        board[B4] = FBB;
+        board[D2] = FWN;
+    });
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, D7, D5 });
+    ASSERT(move_list_matches_candidate_moves(board, PLAYER_WHITE));
+}
+
+TEST(MoveList_ApplyMove_CastlingMovesRook) {
+    auto board = prepare_board([](auto& board) {
+        board[E8] = FBK;
+        board[A8] = FBR;
+        board[E1] = FWK;
+    });
+    const auto moved = apply_move(board, encode_move(E8, C8, MOVE_FLAG_CASTLING));
+
+    ASSERT(FBK == (moved[C8] & 0b1111));
+    ASSERT(FBR == (moved[D8] & 0b1111));
+    ASSERT(PIECE_EMPTY == field_get_piece(moved[A8]));
+    ASSERT(PIECE_EMPTY == field_get_piece(moved[E8]));
+    ASSERT(check_last_move(moved, { PLAYER_BLACK, PIECE_KING, E8, C8 }));
+    ASSERT(!castling_rights_black_long(board_state_meta_get_castling_rights(moved)));
+}
+
+TEST(MoveList_ApplyMove_EnPassantRemovesCapturedPawn) {
+    auto board = two_pawn_board(E5, D7);
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, D7, D5 });
+    const auto moved = apply_move(board, encode_move(E5, D6, MOVE_FLAG_EN_PASSANT));
+
+    ASSERT(FWP == (moved[D6] & 0b1111));
+    ASSERT(PIECE_EMPTY == field_get_piece(moved[D5]));
+    ASSERT(PIECE_EMPTY == field_get_piece(moved[E5]));
+}
+
+bool make_unmake_restores_board(const board_state_t& board, const player_t player) {
+    move_t move_list[256];
+    const move_t* move_list_end = fill_move_list(move_list, board, player);
+    auto hot_board = board;
+    undo_t undo;
+    for (auto it = move_list; it != move_list_end; ++it) {
+        make_move(hot_board, *it, undo);
+        const auto expected = apply_move(board, *it);
+        if (!std::equal(expected.begin(), expected.end(), hot_board.begin())) {
+            test_output << "make_move differs from apply_move for move " << *it << '\n';
+            return false;
+        }
+        unmake_move(hot_board, undo);
+        if (!std::equal(board.begin(), board.end(), hot_board.begin())) {
+            test_output << "unmake_move did not restore board for move " << *it << '\n';
+            return false;
+        }
+    }
+    return move_list != move_list_end;
+}
+
+TEST(MakeMove_UnmakeMoveRestoresBoard_StartBoard) {
+    auto board = prepare_board([](auto& board) { board = START_BOARD; });
+    ASSERT(make_unmake_restores_board(board, PLAYER_WHITE));
+    ASSERT(make_unmake_restores_board(board, PLAYER_BLACK));
+}
+
+TEST(MakeMove_UnmakeMoveRestoresBoard_CastlingPromotionsCaptures) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[A1] = FWR;
+        board[H1] = FWR;
+        board[E8] = FBK;
+        board[A8] = FBR;
+        board[H8] = FBR;
+        board[B7] = FWP;
+        board[G2] = FBP;
+        board[D4] = FWQ;
+        board[D6] = FBN;
+    });
+    ASSERT(make_unmake_restores_board(board, PLAYER_WHITE));
+    ASSERT(make_unmake_restores_board(board, PLAYER_BLACK));
+}
+
+TEST(MakeMove_UnmakeMoveRestoresBoard_EnPassant) {
+    auto board = two_pawn_board(E5, D7);
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, D7, D5 });
+    ASSERT(make_unmake_restores_board(board, PLAYER_WHITE));
+}
+
+TEST(MakeMove_UnmakeMoveRestoresBoard_SequenceOfMoves) {
+    auto board = prepare_board([](auto& board) { board = START_BOARD; });
+    const auto initial_board = board;
+    std::vector<undo_t> undo_stack(4);
+    make_move(board, encode_move(E2, E4, MOVE_FLAG_NONE), undo_stack[0]);
+    make_move(board, encode_move(D7, D5, MOVE_FLAG_NONE), undo_stack[1]);
+    make_move(board, encode_move(E4, D5, MOVE_FLAG_NONE), undo_stack[2]);
+    make_move(board, encode_move(D8, D5, MOVE_FLAG_NONE), undo_stack[3]);
+    ASSERT(FBQ == (board[D5] & 0b1111));
+    ASSERT(check_last_move(board, { PLAYER_BLACK, PIECE_QUEEN, D8, D5 }));
+
+    for (auto it = undo_stack.rbegin(); it != undo_stack.rend(); ++it)
+        unmake_move(board, *it);
+    ASSERT(std::equal(initial_board.begin(), initial_board.end(), board.begin()));
+}
+
+bool attack_map_same_as_full_recompute(const board_state_t& board, const player_t player) {
+    auto c_moves = std::make_unique<board_state_t[]>(256);
+    const board_state_t* c_moves_beg = c_moves.get();
+    const board_state_t* c_moves_end = fill_candidate_moves(c_moves.get(), board, player);
+    return c_moves_beg != c_moves_end and
+        std::all_of(c_moves_beg, c_moves_end, [](const auto& move) {
+            auto expected = move;
+            update_fields_under_attack(expected);
+            return std::equal(expected.begin(), expected.end(), move.begin());
+        });
+}
+
+TEST(Internal_IncrementalAttackMap_SameAsFullRecompute_DiscoveredAttacks) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[A1] = FWR;
+        board[H1] = FWR;
+        board[E8] = FBK;
+        board[A8] = FBR;
+        board[H8] = FBR;
+        board[B7] = FWP;
+        board[G2] = FBP;
+        board[D4] = FWQ;
+        board[D6] = FBN;
+        board[B2] = FWB;
+        board[F6] = FBB;
+        board[E4] = FWN;
+        board[C5] = FBP;
+    });
+    ASSERT(attack_map_same_as_full_recompute(board, PLAYER_WHITE));
+    ASSERT(attack_map_same_as_full_recompute(board, PLAYER_BLACK));
+}
+
+TEST(Internal_IncrementalAttackMap_SameAsFullRecompute_EnPassantAndCastling) {
+    auto board = two_pawn_board(E5, D7, [](auto& board) {
+        board[A1] = FWR;
+        board[H1] = FWR;
+        board[H5] = FBR;
+        board[A5] = FWQ;
+    });
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, D7, D5 });
+    ASSERT(attack_map_same_as_full_recompute(board, PLAYER_WHITE));
+}
+
+bool generation_modes_match(const board_state_t& board, const player_t player) {
+    auto verified_moves = prepare_moves();
+    auto verified_moves_end = fill_candidate_moves(
+        verified_moves.get(), board, player, generation_mode_t::VERIFY_APPLIED);
+    auto legal_moves = prepare_moves();
+    auto legal_moves_end = fill_candidate_moves(
+        legal_moves.get(), board, player, generation_mode_t::PIN_AND_CHECK_AWARE);
+
+    test_output << verified_moves_end - verified_moves.get() << " verified moves, "
+        << legal_moves_end - legal_moves.get() << " pin and check aware moves.\n";
+    return verified_moves.get() != verified_moves_end and
+        std::equal(verified_moves.get(), verified_moves_end, legal_moves.get(), legal_moves_end);
+}
+
+TEST(CandidateMoves_GenerationModes_Pins) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[E8] = FBK;
+        board[E4] = FWR;
+        board[E7] = FBQ;
+        board[C3] = FWB;
+        board[A5] = FBB;
+        board[H4] = FBR;
+        board[G4] = FWN;
+        board[F7] = FBP;
+        board[G6] = FWQ;
+    });
+    ASSERT(generation_modes_match(board, PLAYER_WHITE));
+    ASSERT(generation_modes_match(board, PLAYER_BLACK));
+}
+
+TEST(CandidateMoves_GenerationModes_SingleCheck) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[E8] = FBK;
+        board[A5] = FBB;
+        board[C1] = FWB;
+        board[F3] = FWN;
+        board[H2] = FWR;
+        board[B2] = FWP;
+        board[C2] = FWP;
+    });
+    ASSERT(generation_modes_match(board, PLAYER_WHITE));
+}
+
+TEST(CandidateMoves_GenerationModes_DoubleCheck) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[E8] = FBK;
+        board[E5] = FBR;
+        board[D3] = FBN;
+        board[D1] = FWQ;
+        board[A3] = FWB;
+    });
+    ASSERT(generation_modes_match(board, PLAYER_WHITE));
+}
+
+TEST(CandidateMoves_GenerationModes_KingMovesAlongCheckingRay) {
+    auto board = prepare_board([](auto& board) {
+        board[E4] = FWK;
+        board[E8] = FBK;
+        board[A4] = FBR;
+        board[H7] = FBB;
+        board[D5] = FBP;
+    });
+    ASSERT(generation_modes_match(board, PLAYER_WHITE));
+}
+
+TEST(CandidateMoves_GenerationModes_EnPassantDiscoveredCheck) {
+    auto board = two_pawn_board(E5, D7, [](auto& board) {
+        board[E1] = FF;
+        board[A5] = FWK;
+        board[H5] = FBR;
+    });
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, D7, D5 });
+    ASSERT(generation_modes_match(board, PLAYER_WHITE));
+
+    auto c_moves = prepare_moves();
+    auto c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_WHITE);
+    ASSERT(!check_candidate_move(c_moves.get(), c_moves_end, { PLAYER_WHITE, PIECE_PAWN, E5, D6 }));
+}
+
+TEST(CandidateMoves_Evasions_PinnedPieceCannotCaptureChecker) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[E8] = FBK;
+        board[D3] = FBN;
+        board[D2] = FWQ;
+        board[A5] = FBB;
+        board[C1] = FWN;
+    });
+    ASSERT(generation_modes_match(board, PLAYER_WHITE));
+
+    auto c_moves = prepare_moves();
+    auto c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_WHITE);
+    ASSERT(!check_candidate_move(c_moves.get(), c_moves_end,
+        { PLAYER_WHITE, PIECE_QUEEN, D2, D3 }));
+    ASSERT(check_candidate_move(c_moves.get(), c_moves_end,
+        { PLAYER_WHITE, PIECE_KNIGHT, C1, D3 }));
+}
+
+TEST(CandidateMoves_Evasions_Interpositions) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[A8] = FBK;
+        board[E8] = FBR;
+        board[G1] = FWN;
+        board[C4] = FWB;
+        board[H3] = FWR;
+        board[D2] = FWP;
+        board[F2] = FWP;
+    });
+    ASSERT(generation_modes_match(board, PLAYER_WHITE));
+
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, PLAYER_WHITE);
+    ASSERT(6 == moves_end - moves);
+}
+
+TEST(CandidateMoves_Evasions_EnPassantCapturesChecker) {
+    auto board = two_pawn_board(D5, E7, [](auto& board) {
+        board[E1] = FF;
+        board[F4] = FWK;
+    });
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, E7, E5 });
+    ASSERT(is_king_under_attack(board, PLAYER_WHITE));
+    ASSERT(generation_modes_match(board, PLAYER_WHITE));
+
+    auto c_moves = prepare_moves();
+    auto c_moves_end = fill_candidate_moves(c_moves.get(), board, PLAYER_WHITE);
+    ASSERT(check_candidate_move(c_moves.get(), c_moves_end, { PLAYER_WHITE, PIECE_PAWN, D5, E6 }));
+}
+
+TEST(CandidateMoves_Evasions_PromotionCapturesChecker) {
+    auto board = prepare_board([](auto& board) {
+        board[A1] = FWK;
+        board[H8] = FBK;
+        board[A8] = FBR;
+        board[B7] = FWP;
+    });
+    ASSERT(generation_modes_match(board, PLAYER_WHITE));
+
+    move_t moves[256];
+    move_t* moves_end = fill_capture_moves(moves, board, PLAYER_WHITE);
+    ASSERT(4 == moves_end - moves);
+}
+
+TEST(MoveList_GenerationModes_SameMoves) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK;
+        board[E8] = FBK;
+        board[E4] = FWR;
+        board[E7] = FBQ;
+        board[C3] = FWB;
+        board[A5] = FBB;
+        board[D3] = FBN;
+    });
+    move_t verified_moves[256];
+    move_t* verified_moves_end =
+        fill_move_list(verified_moves, board, PLAYER_WHITE, generation_mode_t::VERIFY_APPLIED);
+    move_t legal_moves[256];
+    move_t* legal_moves_end = fill_move_list(legal_moves, board, PLAYER_WHITE);
+    ASSERT(std::equal(verified_moves, verified_moves_end, legal_moves, legal_moves_end));
+}
+
+bitboard_t fields_mask(std::initializer_list<field_t> fields) {
+    bitboard_t result = 0u;
+    for (const auto field : fields)
+        result |= 1ull << field;
+    return result;
+}
+
+TEST(SliderAttacks_EmptyBoard) {
+    ASSERT(fields_mask({ A7, B6, C5, E3, F2, G1, C3, B2, A1, E5, F6, G7, H8 }) ==
+        bishop_attacks(D4, 0u));
+    ASSERT(fields_mask({ B1, C1, D1, E1, F1, G1, H1, A2, A3, A4, A5, A6, A7, A8 }) ==
+        rook_attacks(A1, 0u));
+    ASSERT(fields_mask({ G7, F6, E5, D4, C3, B2, A1 }) == bishop_attacks(H8, 0u));
+}
+
+TEST(SliderAttacks_StopAtFirstOccupied) {
+    const bitboard_t occupied = fields_mask({ D6, F4, D2, B6, F2, H8, A1 });
+    ASSERT(fields_mask({ D5, D6, E4, F4, D3, D2, C4, B4, A4 }) == rook_attacks(D4, occupied));
+    ASSERT(fields_mask({ C5, B6, E3, F2, C3, B2, A1, E5, F6, G7, H8 }) ==
+        bishop_attacks(D4, occupied));
+    ASSERT(rook_attacks(D4, occupied) == rook_attacks(D4, occupied | fields_mask({ D7, H4 })));
+}
+
+TEST(SliderAttacks_SameAsCandidateMoves) {
+    const auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[E8] = FBK;
+        board[C4] = FWB; board[F5] = FWR; board[B3] = FWQ;
+        board[E6] = FBP; board[F7] = FBN; board[B7] = FBP; board[F2] = FWP;
+    });
+    bitboard_t occupied = 0u;
+    for (uint8_t field_idx = 0; field_idx < 64; ++field_idx) {
+        if (PIECE_EMPTY != field_get_piece(board[field_idx]))
+            occupied |= 1ull << field_idx;
+    }
+    move_t moves[256];
+    const auto moves_end = fill_move_list(moves, board, PLAYER_WHITE);
+    auto targets_from = [&](const field_t from) {
+        bitboard_t result = 0u;
+        for (auto it = moves; it != moves_end; ++it) {
+            if (from == move_get_from(*it))
+                result |= 1ull << move_get_to(*it);
+        }
+        return result;
+    };
+    const bitboard_t white = fields_mask({ E1, C4, F5, B3, F2 });
+    ASSERT((bishop_attacks(C4, occupied) & ~white) == targets_from(C4));
+    ASSERT((rook_attacks(F5, occupied) & ~white) == targets_from(F5));
+    ASSERT(((bishop_attacks(B3, occupied) | rook_attacks(B3, occupied)) & ~white) ==
+        targets_from(B3));
+}
+
+TEST(Internal_SliderAttacks_PextSameAsMagic) {
+    if (slider_index_t::PEXT != detect_slider_index()) {
+        test_output << "PEXT index not selected on this processor, skipped.\n";
+        return;
+    }
+    const auto magic = std::make_unique<slider_attacks_s<slider_index_t::MAGIC>>();
+    const auto pext = std::make_unique<slider_attacks_s<slider_index_t::PEXT>>();
+    const auto detected = std::make_unique<slider_attacks_s<slider_index_t::DETECTED>>(
+        slider_index_t::PEXT);
+
+    uint64_t occupied = 0x9E3779B97F4A7C15ull;
+    for (uint32_t idx = 0; idx < 4096; ++idx) {
+        occupied ^= occupied << 13;
+        occupied ^= occupied >> 7;
+        occupied ^= occupied << 17;
+        const auto field = static_cast<field_t>(idx % 64);
+        const bitboard_t sparse_occupied = occupied & (occupied >> 5);
+        ASSERT(magic->bishop(field, sparse_occupied) == pext->bishop(field, sparse_occupied));
+        ASSERT(magic->rook(field, sparse_occupied) == pext->rook(field, sparse_occupied));
+        ASSERT(detected->bishop(field, sparse_occupied) == pext->bishop(field, sparse_occupied));
+        ASSERT(detected->rook(field, sparse_occupied) == pext->rook(field, sparse_occupied));
+        ASSERT(bishop_attacks(field, sparse_occupied) == pext->bishop(field, sparse_occupied));
+        ASSERT(rook_attacks(field, sparse_occupied) == pext->rook(field, sparse_occupied));
+    }
+}
+
+TEST(Internal_TargetTables_StaticEvaluation) {
+    static_assert(2 == __builtin_popcountll(KNIGHT_TARGETS[A1]), "Knight in the corner");
+    static_assert(8 == __builtin_popcountll(KNIGHT_TARGETS[D4]), "Knight in the centre");
+    static_assert(3 == __builtin_popcountll(KING_TARGETS[H8]), "King in the corner");
+    static_assert((1ull << B3 | 1ull << D3) == PAWN_TARGETS[PLAYER_WHITE][C2], "White pawn");
+    static_assert((1ull << G7) == PAWN_TARGETS[PLAYER_BLACK][H8], "Black pawn at the edge");
+    static_assert((1ull << A2 | 1ull << A1) == FIELD_RAYS[FIELD_DIRECTION_DOWN][A3], "Ray down");
+    static_assert(0u == FIELD_RAYS[FIELD_DIRECTION_RIGHT_UP][H1], "No ray outside the board");
+}
+
+TEST(MoveList_CompileTimePlayer_SameAsRuntimePlayer) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[H1] = FWR; board[E8] = FBK; board[A8] = FBR;
+        board[E4] = FWR; board[E7] = FBQ; board[C3] = FWB; board[A5] = FBB;
+        board[B2] = FWP; board[G7] = FBP; board[D3] = FBN;
+    });
+    for (const auto mode : { generation_mode_t::VERIFY_APPLIED,
+                             generation_mode_t::PIN_AND_CHECK_AWARE }) {
+        move_t runtime_moves[256];
+        move_t* runtime_moves_end = fill_move_list(runtime_moves, board, PLAYER_WHITE, mode);
+        move_t moves[256];
+        move_t* moves_end = fill_move_list<PLAYER_WHITE>(moves, board, mode);
+        ASSERT(runtime_moves != runtime_moves_end);
+        ASSERT(std::equal(runtime_moves, runtime_moves_end, moves, moves_end));
+
+        auto runtime_boards = prepare_moves();
+        auto runtime_boards_end =
+            fill_candidate_moves(runtime_boards.get(), board, PLAYER_BLACK, mode);
+        auto boards = prepare_moves();
+        auto boards_end = fill_candidate_moves<PLAYER_BLACK>(boards.get(), board, mode);
+        ASSERT(runtime_boards.get() != runtime_boards_end);
+        ASSERT(std::equal(runtime_boards.get(), runtime_boards_end, boards.get(), boards_end));
+    }
+}
+
+bool move_captures_or_promotes(const board_state_t& board, const move_t move) {
+    return MOVE_FLAG_EN_PASSANT == move_get_flags(move) or
+        MOVE_FLAG_PROMOTION == move_get_flags(move) or
+        PIECE_EMPTY != field_get_piece(board[move_get_to(move)]);
+}
+
+bool capture_and_quiet_moves_match_move_list(const board_state_t& board, const player_t player) {
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player);
+    move_t split_moves[256];
+    move_t* captures_end = fill_capture_moves(split_moves, board, player);
+    move_t* quiets_end = fill_quiet_moves(captures_end, board, player);
+
+    test_output << moves_end - moves << " moves in move list, " << captures_end - split_moves
+        << " captures, " << quiets_end - captures_end << " quiet moves.\n";
+    if (not std::all_of(split_moves, captures_end, [&](const move_t move) {
+            return move_captures_or_promotes(board, move); }) or
+        std::any_of(captures_end, quiets_end, [&](const move_t move) {
+            return move_captures_or_promotes(board, move); }))
+        return false;
+
+    auto c_moves = std::make_unique<board_state_t[]>(256);
+    const board_state_t* c_captures_end = fill_capture_moves(c_moves.get(), board, player);
+    const board_state_t* c_quiets_end =
+        fill_quiet_moves(c_moves.get() + (c_captures_end - c_moves.get()), board, player);
+    for (auto it = split_moves; it != quiets_end; ++it) {
+        const auto child = apply_move(board, *it);
+        if (not std::equal(child.begin(), child.end(), c_moves[it - split_moves].begin()))
+            return false;
+    }
+
+    std::sort(moves, moves_end);
+    std::sort(split_moves, quiets_end);
+    return c_quiets_end - c_moves.get() == quiets_end - split_moves and
+        std::equal(moves, moves_end, split_moves, quiets_end);
+}
+
+TEST(CaptureAndQuietMoves_SameAsMoveList_StartBoard) {
+    auto board = prepare_board([](auto& board) { board = START_BOARD; });
+    ASSERT(capture_and_quiet_moves_match_move_list(board, PLAYER_WHITE));
+    ASSERT(capture_and_quiet_moves_match_move_list(board, PLAYER_BLACK));
+
+    move_t moves[256];
+    ASSERT(moves == fill_capture_moves(moves, board, PLAYER_WHITE));
+}
+
+TEST(CaptureAndQuietMoves_SameAsMoveList_CastlingAndPromotions) {
+    const auto board = castling_promotions_board();
+    ASSERT(capture_and_quiet_moves_match_move_list(board, PLAYER_WHITE));
+    ASSERT(capture_and_quiet_moves_match_move_list(board, PLAYER_BLACK));
+
+    move_t moves[256];
+    move_t* moves_end = fill_capture_moves<PLAYER_WHITE>(moves, board);
+    ASSERT(15 == moves_end - moves);
+    ASSERT(moves_end == std::find(moves, moves_end, encode_move(E1, G1, MOVE_FLAG_CASTLING)));
+}
+
+TEST(CaptureAndQuietMoves_SameAsMoveList_EnPassantAndPins) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[E5] = FWP; board[F5] = FWR; board[H6] = FBK;
+        board[D7] = FBP; board[B4] = FBB; board[D2] = FWN; board[C4] = FBP;
+    });
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, D7, D5 });
+    ASSERT(capture_and_quiet_moves_match_move_list(board, PLAYER_WHITE));
+
+    move_t moves[256];
+    move_t* moves_end = fill_capture_moves(moves, board, PLAYER_WHITE);
+    ASSERT(moves_end != std::find(moves, moves_end, encode_move(E5, D6, MOVE_FLAG_EN_PASSANT)));
+}
+
+TEST(CaptureAndQuietMoves_SameAsMoveList_DoubleCheck) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[E8] = FBK; board[E5] = FBR;
+        board[D3] = FBN; board[D1] = FWQ; board[A3] = FWB; board[D2] = FBP;
+    });
+    ASSERT(capture_and_quiet_moves_match_move_list(board, PLAYER_WHITE));
+}
+
+bool same_piece_list(const piece_list_t& pieces, const board_state_t& board) {
+    const piece_list_t expected = make_piece_list(board);
+    for (const player_t player : { PLAYER_WHITE, PLAYER_BLACK }) {
+        if (expected.counts[player] != pieces.counts[player] or
+            expected.kings[player] != pieces.kings[player])
+            return false;
+        auto fields = pieces.fields[player];
+        std::sort(fields.begin(), fields.begin() + pieces.counts[player]);
+        if (not std::equal(fields.begin(), fields.begin() + pieces.counts[player],
+                expected.fields[player].begin()))
+            return false;
+        for (uint8_t idx = 0; idx < pieces.counts[player]; ++idx) {
+            if (idx != pieces.indices[pieces.fields[player][idx]])
+                return false;
+        }
+    }
+    return true;
+}
+
+bool piece_list_in_sync(board_state_t& board, piece_list_t& pieces, const player_t player,
+    const int depth) {
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player, pieces);
+    move_t expected_moves[256];
+    move_t* expected_moves_end = fill_move_list(expected_moves, board, player);
+    if (not std::equal(moves, moves_end, expected_moves, expected_moves_end) or
+        is_king_under_attack(board, player) != is_king_under_attack(board, player, pieces))
+        return false;
+
+    for (auto it = moves; it != moves_end; ++it) {
+        undo_t undo;
+        make_move(board, *it, undo, pieces);
+        const bool in_sync = same_piece_list(pieces, board) and
+            (1 == depth or piece_list_in_sync(board, pieces, opponent(player), depth - 1));
+        unmake_move(board, undo, pieces);
+        if (not in_sync or not same_piece_list(pieces, board))
+            return false;
+    }
+    return true;
+}
+
+TEST(PieceList_StartBoard) {
+    auto board = prepare_board([](auto& board) { board = START_BOARD; });
+    const auto pieces = make_piece_list(board);
+    ASSERT(16 == pieces.counts[PLAYER_WHITE]);
+    ASSERT(16 == pieces.counts[PLAYER_BLACK]);
+    ASSERT(E1 == pieces.kings[PLAYER_WHITE]);
+    ASSERT(E8 == pieces.kings[PLAYER_BLACK]);
+    ASSERT(A1 == pieces.fields[PLAYER_WHITE][0]);
+    ASSERT(H8 == pieces.fields[PLAYER_BLACK][15]);
+}
+
+TEST(PieceList_MakeMoveKeepsInSync_CastlingEnPassantPromotions) {
+    auto board = castling_promotions_board();
+    auto pieces = make_piece_list(board);
+    ASSERT(same_piece_list(pieces, board));
+    ASSERT(piece_list_in_sync(board, pieces, PLAYER_WHITE, 3));
+}
+
+TEST(PieceList_MakeMoveKeepsInSync_Check) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[E8] = FBK; board[D3] = FBN; board[D2] = FWQ;
+        board[A5] = FBB; board[C1] = FWN; board[H2] = FWR;
+    });
+    auto pieces = make_piece_list(board);
+    ASSERT(is_king_under_attack(board, PLAYER_WHITE, pieces));
+    ASSERT(piece_list_in_sync(board, pieces, PLAYER_WHITE, 3));
+}
+
+/** Attack bits of ranged pieces skip fields of their own player, so the attack map answers the
+ *  same as `is_square_attacked` only for fields that are empty or occupied by the other player */
+bool square_attacked_same_as_attack_map(const board_state_t& board) {
+    for (uint8_t field_idx = 0; field_idx < 64; ++field_idx) {
+        const auto field = static_cast<field_t>(field_idx);
+        for (const player_t player : { PLAYER_WHITE, PLAYER_BLACK }) {
+            if (PIECE_EMPTY != field_get_piece(board[field]) and
+                player == field_get_player(board[field]))
+                continue;
+            if (is_square_attacked(board, field, player) !=
+                field_under_attack_by(board[field], player))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool square_attacked_same_as_attack_map(const board_state_t& board, const player_t player,
+    const int depth) {
+    if (not square_attacked_same_as_attack_map(board))
+        return false;
+    if (0 == depth)
+        return true;
+
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player);
+    return std::all_of(moves, moves_end, [&](const move_t move) {
+        return square_attacked_same_as_attack_map(
+            apply_move(board, move), opponent(player), depth - 1);
+    });
+}
+
+TEST(SquareAttacked_SameAsAttackMap_StartBoard) {
+    auto board = prepare_board([](auto& board) { board = START_BOARD; });
+    ASSERT(square_attacked_same_as_attack_map(board, PLAYER_WHITE, 2));
+}
+
+TEST(SquareAttacked_SameAsAttackMap_CastlingEnPassantPromotions) {
+    const auto board = castling_promotions_board();
+    ASSERT(square_attacked_same_as_attack_map(board, PLAYER_WHITE, 2));
+}
+
+TEST(SquareAttacked_DefendedPieces) {
+    const auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[E8] = FBK;
+        board[A1] = FWR; board[A4] = FWR; board[D4] = FWP; board[C3] = FWP;
+        board[B5] = FBN; board[H4] = FBR;
+    });
+    ASSERT(is_square_attacked(board, A4, PLAYER_WHITE));
+    ASSERT(is_square_attacked(board, D4, PLAYER_WHITE));
+    ASSERT(not is_square_attacked(board, C3, PLAYER_WHITE));
+    ASSERT(is_square_attacked(board, C3, PLAYER_BLACK));
+    ASSERT(is_square_attacked(board, D4, PLAYER_BLACK));
+    ASSERT(not is_square_attacked(board, A4, PLAYER_BLACK));
+    ASSERT(is_square_attacked(board, D1, PLAYER_WHITE));
+    ASSERT(not is_square_attacked(board, F3, PLAYER_BLACK));
+}
+
+bool legal_moves_same_as_move_list(const board_state_t& board, const player_t player,
+    const int depth) {
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player);
+    std::vector<move_t> expected(moves, moves_end);
+    std::vector<move_t> lazy_moves;
+    for (const move_t move : legal_moves(board, player))
+        lazy_moves.push_back(move);
+    std::sort(expected.begin(), expected.end());
+    std::sort(lazy_moves.begin(), lazy_moves.end());
+    if (expected != lazy_moves or has_legal_move(board, player) != not expected.empty())
+        return false;
+    if (0 == depth)
+        return true;
+
+    return std::all_of(moves, moves_end, [&](const move_t move) {
+        return legal_moves_same_as_move_list(apply_move(board, move), opponent(player), depth - 1);
+    });
+}
+
+TEST(LegalMoves_SameAsMoveList_StartBoard) {
+    ASSERT(legal_moves_same_as_move_list(START_BOARD, PLAYER_WHITE, 2));
+}
+
+TEST(LegalMoves_SameAsMoveList_CastlingEnPassantPromotions) {
+    const auto board = castling_promotions_board();
+    ASSERT(legal_moves_same_as_move_list(board, PLAYER_WHITE, 2));
+}
+
+TEST(LegalMoves_SameAsMoveList_DoubleCheck) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[E8] = FBK;
+        board[E5] = FBR; board[D3] = FBN; board[D1] = FWQ; board[A3] = FWB;
+    });
+    ASSERT(legal_moves_same_as_move_list(board, PLAYER_WHITE, 1));
+}
+
+TEST(LegalMoves_EarlyExit) {
+    std::size_t moves_cnt = 0;
+    for (const move_t move : legal_moves(START_BOARD, PLAYER_BLACK)) {
+        ASSERT(PLAYER_BLACK == field_get_player(START_BOARD[move_get_from(move)]));
+        if (++moves_cnt == 3)
+            break;
+    }
+    ASSERT(3 == moves_cnt);
+}
+
+TEST(HasLegalMove_CheckmateAndStalemate) {
+    const auto checkmate_board = prepare_board([](auto& board) {
+        board[H8] = FBK; board[G7] = FWQ; board[F6] = FWK; board[A7] = FBP;
+    });
+    ASSERT(not has_legal_move(checkmate_board, PLAYER_BLACK));
+    ASSERT(has_legal_move(checkmate_board, PLAYER_WHITE));
+
+    const auto stalemate_board = prepare_board([](auto& board) {
+        board[H8] = FBK; board[F7] = FWQ; board[G6] = FWK; board[A5] = FBP; board[A4] = FWP;
+    });
+    ASSERT(not has_legal_move(stalemate_board, PLAYER_BLACK));
+}
+
+bool move_counts_same_as_move_list(const board_state_t& board, const player_t player,
+    const int depth) {
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player);
+    piece_move_counts_t expected = {};
+    for (auto it = moves; it != moves_end; ++it)
+        ++expected[field_get_piece(board[move_get_from(*it)])];
+    if (expected != count_legal_moves_by_piece(board, player) or
+        static_cast<std::size_t>(moves_end - moves) != count_legal_moves(board, player))
+        return false;
+    if (0 == depth)
+        return true;
+
+    return std::all_of(moves, moves_end, [&](const move_t move) {
+        return move_counts_same_as_move_list(apply_move(board, move), opponent(player), depth - 1);
+    });
+}
+
+TEST(CountLegalMoves_SameAsMoveList_StartBoard) {
+    ASSERT(20 == count_legal_moves(START_BOARD, PLAYER_WHITE));
+    ASSERT(move_counts_same_as_move_list(START_BOARD, PLAYER_WHITE, 3));
+}
+
+TEST(CountLegalMoves_SameAsMoveList_CastlingEnPassantPromotions) {
+    const auto board = castling_promotions_board();
+    ASSERT(move_counts_same_as_move_list(board, PLAYER_WHITE, 2));
+}
+
+TEST(CountLegalMoves_SameAsMoveList_PinsAndChecks) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[E8] = FBK;
+        board[E4] = FWR; board[E6] = FBQ; board[B4] = FWB; board[A5] = FBB; board[D2] = FWN;
+        board[H4] = FBR; board[F2] = FWP; board[G5] = FBN;
+    });
+    ASSERT(move_counts_same_as_move_list(board, PLAYER_WHITE, 2));
+    ASSERT(move_counts_same_as_move_list(board, PLAYER_BLACK, 2));
+}
+
+TEST(CountLegalMoves_ByPiece) {
+    const auto board = prepare_board([](auto& board) {
+        board[A1] = FWK; board[H8] = FBK; board[D4] = FWN; board[B7] = FWP; board[E1] = FWR;
+    });
+    const piece_move_counts_t counts = count_legal_moves_by_piece(board, PLAYER_WHITE);
+    ASSERT(3 == counts[PIECE_KING]);
+    ASSERT(8 == counts[PIECE_KNIGHT]);
+    ASSERT(4 == counts[PIECE_PAWN]);
+    ASSERT(13 == counts[PIECE_ROOK]);
+    ASSERT(0 == counts[PIECE_QUEEN]);
+}
+
+TEST(See_UndefendedAndDefendedCaptures) {
+    const auto board = prepare_board([](auto& board) {
+        board[C1] = FWK; board[B8] = FBK;
+        board[E1] = FWR; board[E5] = FBP; board[D8] = FBR; board[A3] = FWP; board[A6] = FBP;
+        board[D1] = FWQ; board[D7] = FBP; board[C7] = FBP;
+    });
+    ASSERT(100 == see(board, encode_move(E1, E5, MOVE_FLAG_NONE)));
+    // pawn defended by rook
+    ASSERT(-800 == see(board, encode_move(D1, D7, MOVE_FLAG_NONE)));
+    ASSERT(0 == see(board, encode_move(A3, A4, MOVE_FLAG_NONE)));
+}
+
+TEST(See_XRayAttackers) {
+    const auto board = prepare_board([](auto& board) {
+        board[C1] = FWK; board[B8] = FBK;
+        board[D3] = FWN; board[E2] = FWR; board[E1] = FWQ; board[G2] = FWB;
+        board[E5] = FBP; board[D7] = FBN; board[F6] = FBB; board[H8] = FBQ; board[D8] = FBR;
+    });
+    ASSERT(-200 == see(board, encode_move(D3, E5, MOVE_FLAG_NONE)));
+
+    const auto pawn_board = prepare_board([](auto& board) {
+        board[H1] = FWK; board[H8] = FBK;
+        board[C3] = FWP; board[B2] = FWB; board[D4] = FBN; board[E5] = FBP;
+    });
+    ASSERT(300 == see(pawn_board, encode_move(C3, D4, MOVE_FLAG_NONE)));
+    auto no_bishop_board = pawn_board;
+    no_bishop_board[B2] = FF;
+    ASSERT(200 == see(no_bishop_board, encode_move(C3, D4, MOVE_FLAG_NONE)));
+}
+
+TEST(See_KingCapturesOnlyUndefendedPieces) {
+    const auto board = prepare_board([](auto& board) {
+        board[A1] = FWK; board[E8] = FBK; board[D7] = FBP; board[D2] = FWQ;
+    });
+    ASSERT(-800 == see(board, encode_move(D2, D7, MOVE_FLAG_NONE)));
+    auto defended_board = board;
+    defended_board[D1] = FWR;
+    ASSERT(100 == see(defended_board, encode_move(D2, D7, MOVE_FLAG_NONE)));
+}
+
+TEST(See_EnPassantAndPromotions) {
+    auto board = prepare_board([](auto& board) {
+        board[C1] = FWK; board[H3] = FBK;
+        board[B7] = FWP; board[A8] = FBR; board[E5] = FWP; board[D7] = FBP; board[C7] = FBP;
+    });
+    // pawn promoted to queen is lost to the rook
+    const move_t promotion = move_set_promotion(encode_move(B7, B8, MOVE_FLAG_NONE), PIECE_QUEEN);
+    const move_t capture = move_set_promotion(encode_move(B7, A8, MOVE_FLAG_NONE), PIECE_QUEEN);
+    ASSERT(-100 == see(board, promotion));
+    ASSERT(1300 == see(board, capture));
+
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, D7, D5 });
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, PLAYER_WHITE);
+    const move_t en_passant = encode_move(E5, D6, MOVE_FLAG_EN_PASSANT);
+    ASSERT(moves_end != std::find(moves, moves_end, en_passant));
+    ASSERT(0 == see(board, en_passant));
+}
+
+bool gives_check_same_as_apply_move(const board_state_t& board, const player_t player,
+    const int depth) {
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player);
+    return std::all_of(moves, moves_end, [&](const move_t move) {
+        const board_state_t move_board = apply_move(board, move);
+        return gives_check(board, move) == is_king_under_attack(move_board, opponent(player)) and
+            (0 == depth or gives_check_same_as_apply_move(move_board, opponent(player), depth - 1));
+    });
+}
+
+TEST(GivesCheck_SameAsApplyMove_StartBoard) {
+    ASSERT(gives_check_same_as_apply_move(START_BOARD, PLAYER_WHITE, 3));
+}
+
+TEST(GivesCheck_SameAsApplyMove_CastlingEnPassantPromotions) {
+    const auto board = castling_promotions_board();
+    ASSERT(gives_check_same_as_apply_move(board, PLAYER_WHITE, 2));
+}
+
+TEST(GivesCheck_DiscoveredChecks) {
+    auto board = prepare_board([](auto& board) {
+        board[A1] = FWK; board[D1] = FBK;
+        board[H1] = FWR; board[E1] = FWN; board[A4] = FWB; board[C2] = FWP; board[F5] = FWP;
+        board[E7] = FBP;
+    });
+    // knight uncovers rook, pawn uncovers bishop
+    ASSERT(gives_check(board, encode_move(E1, G2, MOVE_FLAG_NONE)));
+    ASSERT(gives_check(board, encode_move(C2, C3, MOVE_FLAG_NONE)));
+    ASSERT(not gives_check(board, encode_move(F5, F6, MOVE_FLAG_NONE)));
+    ASSERT(gives_check_same_as_apply_move(board, PLAYER_WHITE, 1));
+
+    // en passant vacates two fields of the rank of the checked king
+    auto en_passant_board = prepare_board([](auto& board) {
+        board[A1] = FWK; board[H5] = FBK; board[A5] = FWR; board[C5] = FWP; board[D7] = FBP;
+    });
+    apply_move_if_valid(&en_passant_board, { PLAYER_BLACK, PIECE_PAWN, D7, D5 });
+    ASSERT(gives_check(en_passant_board, encode_move(C5, D6, MOVE_FLAG_EN_PASSANT)));
+    ASSERT(gives_check_same_as_apply_move(en_passant_board, PLAYER_WHITE, 1));
+}
+
+TEST(GivesCheck_CastlingRook) {
+    const auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[H1] = FWR; board[A1] = FWR; board[F8] = FBK;
+    });
+    ASSERT(gives_check(board, encode_move(E1, G1, MOVE_FLAG_CASTLING)));
+    ASSERT(not gives_check(board, encode_move(E1, C1, MOVE_FLAG_CASTLING)));
+    ASSERT(gives_check_same_as_apply_move(board, PLAYER_WHITE, 1));
+}
+
+bool position_key_after_move_same_as_position_key(const board_state_t& board,
+    const player_t player, const int depth) {
+    const position_key_t key = position_key(board);
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player);
+    return std::all_of(moves, moves_end, [&](const move_t move) {
+        const board_state_t move_board = apply_move(board, move);
+        return position_key_after_move(board, key, move) == position_key(move_board) and
+            (0 == depth or
+             position_key_after_move_same_as_position_key(move_board, opponent(player), depth - 1));
+    });
+}
+
+TEST(PositionKey_AfterMoveSameAsPositionKey_StartBoard) {
+    ASSERT(position_key_after_move_same_as_position_key(START_BOARD, PLAYER_WHITE, 3));
+}
+
+TEST(PositionKey_AfterMoveSameAsPositionKey_CastlingEnPassantPromotions) {
+    const auto board = castling_promotions_board();
+    ASSERT(position_key_after_move_same_as_position_key(board, PLAYER_WHITE, 2));
+}
+
+TEST(PositionKey_Transpositions) {
+    auto play_moves = [](board_state_t board, std::initializer_list<move_s> moves) {
+        for (const auto& move : moves)
+            ASSERT(&board != apply_move_if_valid(&board, move));
+        return board;
+    };
+    const auto knights_board = play_moves(START_BOARD, {
+        { PLAYER_WHITE, PIECE_KNIGHT, G1, F3 }, { PLAYER_BLACK, PIECE_KNIGHT, G8, F6 },
+        { PLAYER_WHITE, PIECE_KNIGHT, F3, G1 }, { PLAYER_BLACK, PIECE_KNIGHT, F6, G8 } });
+    ASSERT(not std::equal(START_BOARD.begin(), START_BOARD.end(), knights_board.begin()));
+    ASSERT(position_key(START_BOARD) == position_key(knights_board));
+
+    // last move differs, but allows no en passant capture
+    const auto e4_d5_board = play_moves(START_BOARD, {
+        { PLAYER_WHITE, PIECE_PAWN, E2, E4 }, { PLAYER_BLACK, PIECE_PAWN, D7, D5 } });
+    const auto e3_d6_board = play_moves(START_BOARD, {
+        { PLAYER_WHITE, PIECE_PAWN, E2, E3 }, { PLAYER_BLACK, PIECE_PAWN, D7, D6 },
+        { PLAYER_WHITE, PIECE_PAWN, E3, E4 }, { PLAYER_BLACK, PIECE_PAWN, D6, D5 } });
+    ASSERT(position_key(e4_d5_board) == position_key(e3_d6_board));
+
+    // en passant possible only after the double step
+    const auto e5_board = play_moves(START_BOARD, {
+        { PLAYER_WHITE, PIECE_PAWN, E2, E4 }, { PLAYER_BLACK, PIECE_PAWN, A7, A6 },
+        { PLAYER_WHITE, PIECE_PAWN, E4, E5 }, { PLAYER_BLACK, PIECE_PAWN, D7, D5 } });
+    auto e5_single_step_board = e5_board;
+    last_move_t last_move = board_state_meta_get_last_move(e5_board);
+    last_move = last_move_set_from(last_move, D6);
+    board_state_meta_set_last_move(e5_single_step_board, last_move);
+    ASSERT(position_key(e5_board) != position_key(e5_single_step_board));
+}
+
+bool pawn_and_material_keys_after_move_same_as_full(const board_state_t& board,
+    const player_t player, const int depth) {
+    const position_key_t key = pawn_key(board);
+    const material_key_t material = material_key(board);
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player);
+    return std::all_of(moves, moves_end, [&](const move_t move) {
+        const board_state_t move_board = apply_move(board, move);
+        return pawn_key_after_move(board, key, move) == pawn_key(move_board) and
+            material_key_after_move(board, material, move) == material_key(move_board) and
+            (0 == depth or
+             pawn_and_material_keys_after_move_same_as_full(move_board, opponent(player),
+                depth - 1));
+    });
+}
+
+TEST(PawnAndMaterialKeys_AfterMoveSameAsFull_StartBoard) {
+    ASSERT(pawn_and_material_keys_after_move_same_as_full(START_BOARD, PLAYER_WHITE, 3));
+}
+
+TEST(PawnAndMaterialKeys_AfterMoveSameAsFull_CastlingEnPassantPromotions) {
+    const auto board = castling_promotions_board();
+    ASSERT(pawn_and_material_keys_after_move_same_as_full(board, PLAYER_WHITE, 2));
+}
+
+TEST(MaterialKey_Counts) {
+    const material_key_t material = material_key(START_BOARD);
+    for (const player_t player : { PLAYER_WHITE, PLAYER_BLACK }) {
+        ASSERT(8 == material_key_count(material, player, PIECE_PAWN));
+        ASSERT(2 == material_key_count(material, player, PIECE_KNIGHT));
+        ASSERT(2 == material_key_count(material, player, PIECE_BISHOP));
+        ASSERT(2 == material_key_count(material, player, PIECE_ROOK));
+        ASSERT(1 == material_key_count(material, player, PIECE_QUEEN));
+    }
+
+    const auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[E8] = FBK; board[C3] = FWN; board[D5] = FBN; board[F6] = FBN;
+    });
+    ASSERT(1 == material_key_count(material_key(board), PLAYER_WHITE, PIECE_KNIGHT));
+    ASSERT(2 == material_key_count(material_key(board), PLAYER_BLACK, PIECE_KNIGHT));
+    ASSERT(0 == material_key_count(material_key(board), PLAYER_BLACK, PIECE_PAWN));
+    ASSERT(material_key(board) != material_key(EMPTY_BOARD));
+}
+
+TEST(PawnKey_IgnoresPieces) {
+    auto board = START_BOARD;
+    apply_move_if_valid(&board, { PLAYER_WHITE, PIECE_KNIGHT, G1, F3 });
+    ASSERT(pawn_key(START_BOARD) == pawn_key(board));
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, E7, E5 });
+    ASSERT(pawn_key(START_BOARD) != pawn_key(board));
+}
+
+TEST(CompareSimplePosition_IgnoresAttackMetaAndEmptyFieldPlayerBits) {
+    auto board = START_BOARD;
+    update_fields_under_attack(board);
+    auto other = START_BOARD;
+    board_state_meta_set_last_move(other, last_move_set_player(last_move_t{}, PLAYER_BLACK));
+    other[E4] = field_set_player(other[E4], PLAYER_WHITE);
+    other[D5] = field_set_player(other[D5], PLAYER_BLACK);
+    ASSERT(compare_simple_position(board, other));
+
+    other = board;
+    other[G7] = FBB;
+    ASSERT(not compare_simple_position(board, other));
+    other = board;
+    other[H8] = FWR;
+    ASSERT(not compare_simple_position(board, other));
+    other = board;
+    other[A2] = FBP;
+    ASSERT(not compare_simple_position(board, other));
+    other = board;
+    board_state_meta_set_castling_rights(other, CASTLING_RIGHTS_BLACK_SHORT);
+    ASSERT(not compare_simple_position(board, other));
+}
+
+TEST(PlayerFields_SameAsFieldScan) {
+    auto board = prepare_board([](auto& board) {
+        board[A1] = FWR; board[E1] = FWK; board[D2] = FWB; board[E4] = FWP; board[C3] = FWN;
+        board[H3] = FBP; board[B4] = FBP; board[D5] = FWP; board[F6] = FBN; board[G7] = FBB;
+        board[A8] = FBR; board[E8] = FBK; board[H8] = FBR; board[E7] = FBQ;
+    });
+    board[C6] = field_set_player(board[C6], PLAYER_WHITE);
+
+    std::array<bitboard_t, 2> expected = {};
+    for (uint8_t field_idx = 0; field_idx < 64; ++field_idx) {
+        if (not field_empty(board[field_idx]))
+            expected[field_get_player(board[field_idx])] |= 1ull << field_idx;
+    }
+    ASSERT(expected == player_fields(board));
+    ASSERT((expected[PLAYER_WHITE] | expected[PLAYER_BLACK]) == occupied_fields(board));
+}
+
+TEST(ClearFieldsUnderAttack_KeepsOtherBits) {
+    auto board = START_BOARD;
+    board_state_meta_set_castling_rights(board, CASTLING_RIGHTS_WHITE_LONG);
+    apply_move_if_valid(&board, { PLAYER_WHITE, PIECE_PAWN, E2, E4 });
+    auto cleared = board;
+    clear_fields_under_attack(cleared);
+
+    for (uint8_t field_idx = 0; field_idx < 64; ++field_idx) {
+        ASSERT(field_clear_under_black_attack(field_clear_under_white_attack(board[field_idx])) ==
+            cleared[field_idx]);
+    }
+    ASSERT(board_state_meta_get_last_move(board) == board_state_meta_get_last_move(cleared));
+    update_fields_under_attack(cleared);
+    ASSERT(std::equal(board.begin(), board.end(), cleared.begin()));
+}
@@ -3,6 +3,7 @@
 #include "chess/gameplay.hpp"
 #include "chess/gui_tty.hpp"
 #include "chesstest.hpp"
+#include "test_boards.hpp"
 
 using namespace chess;
 
@@ -119,14 +120,6 @@ TEST(Gameplay_Play_AfterWhiteMoveBlackIsRequestedToMove) {
     ASSERT(game_result_t::WHITE_WON_FORFEIT == do_play(white_to_play, forfeit_on_1st_move));
 }
 
-board_state_t prepare_board(std::function<void(board_state_t&)> setup_fn) {
-    auto board = chess::EMPTY_BOARD;
-    setup_fn(board);
-    update_fields_under_attack(board);
-    // draw_board(board);
-    return board;
-}
-
 TEST(Gameplay_Play_AfterWhitesMoveBlackIsCheckmatedAndWhiteWins) {
     auto board = prepare_board([](auto& board){
         board[A1] = FBK;
@@ -169,6 +162,36 @@ TEST(Gameplay_Play_BlacksRidiculousMovesIsNotAllowed) {
     ASSERT(game_result_t::WHITE_WON_FORFEIT == do_play(white_to_play, black_to_play, board));
 }
 
+game_action_t white_castles_after_move_seq(board_state_t& board) {
+    if (white_move_idx < white_move_seq().size())
+        return white_to_play(board);
+
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, PLAYER_WHITE);
+    const move_t* castling = std::find_if(moves, moves_end, [](const move_t move) {
+        return MOVE_FLAG_CASTLING == move_get_flags(move);
+    });
+    if (moves_end == castling)
+        return game_action_t::FORFEIT;
+
+    board = apply_move(board, *castling);
+    return game_action_t::MOVE;
+}
+
+TEST(Gameplay_Play_NoCastlingThroughAttackedFieldOfBoardWithoutFieldsUnderAttack) {
+    auto board = EMPTY_BOARD;
+    board[E1] = FWK;
+    board[H1] = FWR;
+    board[A2] = FWP;
+    board[A7] = FBP;
+    board[E8] = FBK;
+    board[F8] = FBR;
+    fill_white_move_seq({ { PLAYER_WHITE, PIECE_PAWN, A2, A3 } });
+    fill_black_move_seq({ { PLAYER_BLACK, PIECE_PAWN, A7, A6 } });
+    ASSERT(game_result_t::BLACK_WON_FORFEIT ==
+        do_play(white_castles_after_move_seq, black_to_play, board));
+}
+
 TEST(Gameplay_Play_CheckMateInTwoFromBlack) {
     auto board = prepare_board([](auto& board){
         board[A1] = FWK;
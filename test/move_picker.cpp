@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <vector>
+#include "chess/move_picker.hpp"
+#include "chesstest.hpp"
+#include "test_boards.hpp"
+
+using namespace chess;
+
+struct picked_move_t {
+    move_t move;
+    move_picker_stage_t stage;
+};
+
+std::vector<picked_move_t> pick_all(move_picker_t picker) {
+    std::vector<picked_move_t> moves;
+    for (move_t move = next_move(picker); MOVE_NONE != move; move = next_move(picker))
+        moves.push_back({ move, picker.stage });
+    return moves;
+}
+
+bool same_moves_as_move_list(const board_state_t& board, const player_t player,
+    const move_t hash_move = MOVE_NONE, const std::array<move_t, 2>& killer_moves = {}) {
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player);
+    std::vector<move_t> expected(moves, moves_end);
+    std::vector<move_t> picked;
+    for (const auto& picked_move : pick_all(make_move_picker(board, player, hash_move,
+             killer_moves)))
+        picked.push_back(picked_move.move);
+
+    test_output << expected.size() << " moves in move list, " << picked.size()
+        << " picked moves.\n";
+    std::sort(expected.begin(), expected.end());
+    std::sort(picked.begin(), picked.end());
+    return expected == picked;
+}
+
+bool stages_ordered(const std::vector<picked_move_t>& moves) {
+    return std::is_sorted(moves.begin(), moves.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.stage < rhs.stage;
+    });
+}
+
+TEST(MovePicker_SameAsMoveList_StartBoard) {
+    ASSERT(same_moves_as_move_list(START_BOARD, PLAYER_WHITE));
+    ASSERT(same_moves_as_move_list(START_BOARD, PLAYER_BLACK));
+}
+
+TEST(MovePicker_SameAsMoveList_Kiwipete) {
+    const auto board = kiwipete_board();
+    ASSERT(same_moves_as_move_list(board, PLAYER_WHITE));
+    ASSERT(same_moves_as_move_list(board, PLAYER_BLACK));
+}
+
+TEST(MovePicker_SameAsMoveList_EnPassantAndPromotions) {
+    auto board = prepare_board([](auto& board) {
+        board[E1] = FWK; board[H8] = FBK;
+        board[B7] = FWP; board[A8] = FBR; board[C8] = FBN;
+        board[G2] = FBP; board[F1] = FWB; board[D4] = FBP; board[E2] = FWP;
+    });
+    ASSERT(same_moves_as_move_list(board, PLAYER_WHITE));
+    apply_move_if_valid(&board, { PLAYER_WHITE, PIECE_PAWN, E2, E4 });
+    ASSERT(same_moves_as_move_list(board, PLAYER_BLACK));
+}
+
+TEST(MovePicker_SameAsMoveList_Check) {
+    const auto board = prepare_board([](auto& board) {
+        board[E8] = FBK; board[E4] = FWK; board[D4] = FWP;
+        board[F5] = FWN; board[A4] = FBR; board[H7] = FBB; board[C5] = FBP;
+        board[E1] = FBR;
+    });
+    ASSERT(is_king_under_attack(board, PLAYER_WHITE));
+    ASSERT(same_moves_as_move_list(board, PLAYER_WHITE));
+}
+
+TEST(MovePicker_StagesOrdered_Kiwipete) {
+    const auto moves = pick_all(make_move_picker(kiwipete_board(), PLAYER_WHITE));
+    ASSERT(stages_ordered(moves));
+    ASSERT(move_picker_stage_t::CAPTURES == moves.front().stage);
+    ASSERT(move_picker_stage_t::QUIETS == moves.back().stage);
+}
+
+TEST(MovePicker_Captures_MostValuableVictimFirst) {
+    const auto board = prepare_board([](auto& board) {
+        board[H1] = FWK; board[H6] = FBK;
+        board[D4] = FWQ; board[E4] = FWP;
+        board[D5] = FBP; board[F5] = FBR; board[A7] = FBQ;
+    });
+    const auto moves = pick_all(make_move_picker(board, PLAYER_WHITE));
+    // queen takes queen, pawn takes rook, and pawn is taken by pawn before it is taken by queen
+    ASSERT(encode_move(D4, A7, MOVE_FLAG_NONE) == moves[0].move);
+    ASSERT(encode_move(E4, F5, MOVE_FLAG_NONE) == moves[1].move);
+    ASSERT(encode_move(E4, D5, MOVE_FLAG_NONE) == moves[2].move);
+    ASSERT(encode_move(D4, D5, MOVE_FLAG_NONE) == moves[3].move);
+    ASSERT(move_picker_stage_t::QUIETS == moves[4].stage);
+}
+
+TEST(MovePicker_Promotions_QueenFirst) {
+    const auto board = prepare_board([](auto& board) {
+        board[A1] = FWK; board[H1] = FBK; board[B7] = FWP;
+    });
+    const auto moves = pick_all(make_move_picker(board, PLAYER_WHITE));
+    ASSERT(move_picker_stage_t::PROMOTIONS == moves[0].stage);
+    ASSERT(PIECE_QUEEN == move_get_promotion(moves[0].move));
+    ASSERT(move_picker_stage_t::PROMOTIONS == moves[3].stage);
+    ASSERT(move_picker_stage_t::QUIETS == moves[4].stage);
+}
+
+TEST(MovePicker_HashMove_PickedFirstAndOnce) {
+    const auto board = kiwipete_board();
+    const move_t hash_move = encode_move(E1, G1, MOVE_FLAG_CASTLING);
+    const auto moves = pick_all(make_move_picker(board, PLAYER_WHITE, hash_move));
+
+    ASSERT(hash_move == moves.front().move);
+    ASSERT(move_picker_stage_t::HASH_MOVE == moves.front().stage);
+    ASSERT(1 == std::count_if(moves.begin(), moves.end(), [&](const auto& picked_move) {
+        return hash_move == picked_move.move;
+    }));
+    ASSERT(stages_ordered(moves));
+    ASSERT(same_moves_as_move_list(board, PLAYER_WHITE, hash_move));
+}
+
+TEST(MovePicker_HashMove_IllegalSkipped) {
+    const auto board = kiwipete_board();
+    const move_t hash_move = encode_move(E2, E4, MOVE_FLAG_NONE);
+    const auto moves = pick_all(make_move_picker(board, PLAYER_WHITE, hash_move));
+
+    ASSERT(move_picker_stage_t::CAPTURES == moves.front().stage);
+    ASSERT(same_moves_as_move_list(board, PLAYER_WHITE, hash_move));
+    ASSERT(same_moves_as_move_list(board, PLAYER_BLACK, encode_move(E8, G8, MOVE_FLAG_CASTLING)));
+}
+
+TEST(MovePicker_Killers_PickedAfterCapturesAndOnce) {
+    const auto board = kiwipete_board();
+    const std::array<move_t, 2> killer_moves = {
+        encode_move(A2, A3, MOVE_FLAG_NONE), encode_move(D5, E6, MOVE_FLAG_NONE)
+    };
+    const auto moves = pick_all(make_move_picker(board, PLAYER_WHITE, MOVE_NONE, killer_moves));
+    const auto killers_beg = std::find_if(moves.begin(), moves.end(), [](const auto& move) {
+        return move_picker_stage_t::KILLERS == move.stage;
+    });
+
+    // capture is not a killer, it is picked once as a capture
+    ASSERT(killers_beg != moves.end());
+    ASSERT(killer_moves[0] == killers_beg->move);
+    ASSERT(move_picker_stage_t::QUIETS == (killers_beg + 1)->stage);
+    for (const auto killer_move : killer_moves) {
+        ASSERT(1 == std::count_if(moves.begin(), moves.end(), [&](const auto& picked_move) {
+            return killer_move == picked_move.move;
+        }));
+    }
+    ASSERT(stages_ordered(moves));
+    ASSERT(same_moves_as_move_list(board, PLAYER_WHITE, MOVE_NONE, killer_moves));
+}
+
+TEST(MovePicker_Killers_SameAsHashMovePickedOnce) {
+    const auto board = kiwipete_board();
+    const move_t hash_move = encode_move(A2, A3, MOVE_FLAG_NONE);
+    const std::array<move_t, 2> killer_moves = { hash_move, hash_move };
+    const auto moves = pick_all(make_move_picker(board, PLAYER_WHITE, hash_move, killer_moves));
+
+    ASSERT(1 == std::count_if(moves.begin(), moves.end(), [&](const auto& picked_move) {
+        return hash_move == picked_move.move;
+    }));
+    ASSERT(moves.end() == std::find_if(moves.begin(), moves.end(), [](const auto& move) {
+        return move_picker_stage_t::KILLERS == move.stage;
+    }));
+    ASSERT(same_moves_as_move_list(board, PLAYER_WHITE, hash_move, killer_moves));
+}
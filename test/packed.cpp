@@ -0,0 +1,78 @@
+#include <memory>
+#include <algorithm>
+#include "chess/packed.hpp"
+#include "chesstest.hpp"
+#include "test_boards.hpp"
+
+using namespace chess;
+
+/** Packs and unpacks every position reachable within `depth` plies */
+bool round_trip_keeps_positions(const board_state_t& board, const player_t player,
+    const std::size_t depth) {
+    if (not same_position(board, make_board_state(make_packed_position(board)))) {
+        test_output << "Position changed by packing.\n";
+        return false;
+    }
+    if (0 == depth)
+        return true;
+
+    move_t moves[256];
+    move_t* moves_end = fill_move_list(moves, board, player);
+    return std::all_of(moves, moves_end, [&](const move_t move) {
+        return round_trip_keeps_positions(apply_move(board, move), opponent(player), depth - 1);
+    });
+}
+
+TEST(Packed_Layout_StartBoard) {
+    const auto position = make_packed_position(START_BOARD);
+
+    ASSERT(((FWR & 0x0F) | (FWN & 0x0F) << 4) == position.fields[0]);
+    ASSERT(((FWB & 0x0F) | (FWQ & 0x0F) << 4) == position.fields[C1 / 2]);
+    ASSERT(((FWK & 0x0F) | (FWB & 0x0F) << 4) == position.fields[E1 / 2]);
+    ASSERT(((FBP & 0x0F) | (FBP & 0x0F) << 4) == position.fields[A7 / 2]);
+    ASSERT(((FBN & 0x0F) | (FBR & 0x0F) << 4) == position.fields[G8 / 2]);
+    ASSERT(std::all_of(position.fields.begin() + A3 / 2, position.fields.begin() + A7 / 2,
+        [](const uint8_t fields) { return 0u == fields; }));
+}
+
+TEST(Packed_RoundTrip_StartBoard) {
+    auto board = START_BOARD;
+    update_fields_under_attack(board);
+
+    ASSERT(std::equal(board.begin(), board.end(),
+        make_board_state(make_packed_position(board)).begin()));
+}
+
+TEST(Packed_RoundTrip_KeepsMetaState) {
+    auto board = kiwipete_board();
+    board_state_meta_set_castling_rights(board, CASTLING_RIGHTS_WHITE_LONG);
+    apply_move_if_valid(&board, { PLAYER_BLACK, PIECE_PAWN, C7, C5 });
+    const auto position = make_packed_position(board);
+
+    ASSERT(CASTLING_RIGHTS_WHITE_LONG == position.castling_rights);
+    ASSERT(board_state_meta_get_last_move(board) == position.last_move);
+    ASSERT(same_position(board, make_board_state(position)));
+}
+
+TEST(Packed_RoundTrip_KeepsPositions_Kiwipete) {
+    ASSERT(round_trip_keeps_positions(kiwipete_board(), PLAYER_WHITE, 2));
+}
+
+TEST(Packed_CompareSimplePosition_EmptyFieldsPackedAsZero) {
+    auto board = START_BOARD;
+    update_fields_under_attack(board);
+    auto other = board;
+    apply_move_if_valid(&other, { PLAYER_WHITE, PIECE_KNIGHT, G1, F3 });
+    apply_move_if_valid(&other, { PLAYER_BLACK, PIECE_KNIGHT, G8, F6 });
+    apply_move_if_valid(&other, { PLAYER_WHITE, PIECE_KNIGHT, F3, G1 });
+    ASSERT(not compare_simple_position(make_packed_position(board), make_packed_position(other)));
+    apply_move_if_valid(&other, { PLAYER_BLACK, PIECE_KNIGHT, F6, G8 });
+
+    // knights left their fields empty with player bits set, which are not packed
+    ASSERT(not std::equal(board.begin(), board.end(), other.begin()));
+    ASSERT(compare_simple_position(board, other));
+    ASSERT(compare_simple_position(make_packed_position(board), make_packed_position(other)));
+
+    board_state_meta_set_castling_rights(other, CASTLING_RIGHTS_BLACK_SHORT);
+    ASSERT(not compare_simple_position(make_packed_position(board), make_packed_position(other)));
+}
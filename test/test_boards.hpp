@@ -0,0 +1,76 @@
+#ifndef TEST_TEST_BOARDS_HPP_
+#define TEST_TEST_BOARDS_HPP_
+
+#include <functional>
+#include "chess/core.hpp"
+
+using namespace chess;
+
+board_state_t prepare_board(std::function<void(board_state_t&)> setup_fn) {
+    auto board = chess::EMPTY_BOARD;
+    setup_fn(board);
+    update_fields_under_attack(board);
+    return board;
+}
+
+/** r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R - castling, en-passant, promotions */
+board_state_t kiwipete_board() {
+    return prepare_board([](auto& board) {
+        board[A1] = FWR; board[E1] = FWK; board[H1] = FWR;
+        board[A2] = FWP; board[B2] = FWP; board[C2] = FWP; board[D2] = FWB;
+        board[E2] = FWB; board[F2] = FWP; board[G2] = FWP; board[H2] = FWP;
+        board[C3] = FWN; board[F3] = FWQ; board[H3] = FBP;
+        board[B4] = FBP; board[E4] = FWP;
+        board[D5] = FWP; board[E5] = FWN;
+        board[A6] = FBB; board[B6] = FBN; board[E6] = FBP; board[F6] = FBN; board[G6] = FBP;
+        board[A7] = FBP; board[C7] = FBP; board[D7] = FBP; board[E7] = FBQ; board[F7] = FBP;
+        board[G7] = FBB;
+        board[A8] = FBR; board[E8] = FBK; board[H8] = FBR;
+    });
+}
+
+/** r1n1k2r/1P6/b7/8/3p4/5Q2/4P1p1/R3K2R - castling, en-passant after e2e4, promotions */
+board_state_t castling_promotions_board() {
+    return prepare_board([](auto& board) {
+        board[E1] = FWK; board[A1] = FWR; board[H1] = FWR; board[E2] = FWP; board[B7] = FWP;
+        board[E8] = FBK; board[A8] = FBR; board[H8] = FBR; board[D4] = FBP; board[G2] = FBP;
+        board[C8] = FBN; board[F3] = FWQ; board[A6] = FBB;
+    });
+}
+
+/** Applies `move` as described, without move list flags, and returns pointer past `moves` if
+ *  the player's king is not left in check
+ *  Lets tests make moves of pieces which are not on the board or moves that are not legal, which
+ *  `apply_move` cannot express.
+ */
+board_state_t* apply_move_if_valid(board_state_t* moves, const move_s& move) {
+    auto& board = *moves;
+    undo_t undo;
+    undo.fields_cnt = 0;
+    save_field_state(board, undo, move.from);
+    save_field_state(board, undo, move.to);
+    board[move.from] = field_set_piece(board[move.from], PIECE_EMPTY);
+    board[move.to] = field_set_piece(field_set_player(board[move.to], move.player), move.piece);
+
+    update_fields_under_attack(board, undo);
+    if (not is_king_under_attack(board, move.player)) {
+        update_last_move(board, move);
+        update_castling_rights(board, move);
+        return moves + 1;
+    }
+    return moves;
+}
+
+/** Compares everything that is not transient in `board_state_t` - player of an empty field is
+ *  not meaningful, so it is skipped */
+bool same_position(const board_state_t& lhs, const board_state_t& rhs) {
+    for (uint8_t field_idx = 0; field_idx < 64; ++field_idx) {
+        if (field_under_white_attack(lhs[field_idx]) != field_under_white_attack(rhs[field_idx]) or
+            field_under_black_attack(lhs[field_idx]) != field_under_black_attack(rhs[field_idx]))
+            return false;
+    }
+    return compare_simple_position(lhs, rhs) and
+        board_state_meta_get_last_move(lhs) == board_state_meta_get_last_move(rhs);
+}
+
+#endif  // TEST_TEST_BOARDS_HPP_